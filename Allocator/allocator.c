@@ -0,0 +1,323 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+
+#define ARENA_DEFAULT_BLOCK_SIZE (((size_t)1) << 16)
+#define ARENA_MIN_BLOCK_SIZE ((size_t)256)
+#define POOL_DEFAULT_SLAB_SIZE (((size_t)1) << 16)
+
+/* Largest alignment an arena hands out memory with, enough
+   for any type
+*/
+#define ARENA_ALIGNMENT ((size_t)16)
+
+typedef struct __arena_block_struct_t {
+  struct __arena_block_struct_t *next;
+  size_t size;
+} __arena_block_t;
+
+/* The first bytes of the current block, blocks->next, ...
+   are in use up to pos
+*/
+struct __arena_struct_t {
+  allocator_t allocator;
+  size_t block_size;
+  __arena_block_t *blocks;
+  unsigned char *pos;
+  unsigned char *end;
+  size_t number_bytes;
+};
+
+/* A free block of a pool holds the next free block. The
+   blocks of the current slab, slabs, are handed out from pos
+   up to end, once the free list is empty.
+*/
+typedef struct __pool_free_block_struct_t {
+  struct __pool_free_block_struct_t *next;
+} __pool_free_block_t;
+
+struct __pool_struct_t {
+  allocator_t allocator;
+  size_t object_size;
+  size_t slab_size;
+  __arena_block_t *slabs;
+  unsigned char *pos;
+  unsigned char *end;
+  __pool_free_block_t *free_blocks;
+  size_t number_bytes;
+  size_t holders;
+};
+
+/* Size of the block header, rounded up to the alignment */
+#define ARENA_BLOCK_HEADER                                  \
+  ((sizeof(__arena_block_t) + ARENA_ALIGNMENT - ((size_t)1)) & \
+   ~(ARENA_ALIGNMENT - ((size_t)1)))
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+void *allocate_memory(allocator_t *allocator, size_t size) {
+  void *ptr;
+
+  if (allocator == NULL) {
+    ptr = malloc(size);
+  } else {
+    ptr = allocator->allocate(size, allocator->data);
+  }
+  if ((ptr == NULL) && (size > ((size_t)0))) error_no_mem();
+
+  return ptr;
+}
+
+void *allocate_zeroed_memory(allocator_t *allocator, size_t n, size_t size) {
+  void *ptr;
+
+  if (allocator == NULL) {
+    ptr = calloc(n, size);
+    if ((ptr == NULL) && (n > ((size_t)0)) && (size > ((size_t)0))) {
+      error_no_mem();
+    }
+    return ptr;
+  }
+
+  if ((size > ((size_t)0)) && (n > (SIZE_MAX / size))) error_no_mem();
+  ptr = allocate_memory(allocator, n * size);
+  if (ptr != NULL) memset(ptr, 0, n * size);
+
+  return ptr;
+}
+
+void free_memory(allocator_t *allocator, void *ptr, size_t size) {
+  if (ptr == NULL) return;
+
+  if (allocator == NULL) {
+    free(ptr);
+  } else {
+    allocator->deallocate(ptr, size, allocator->data);
+  }
+}
+
+static void *__allocate_from_arena(size_t size, void *data) {
+  arena_t *arena = data;
+
+  return allocate_in_arena(arena, size);
+}
+
+static void __deallocate_to_arena(void *ptr, size_t size, void *data) {}
+
+arena_t *create_arena(size_t block_size) {
+  arena_t *arena;
+
+  arena = (arena_t *)calloc(1, sizeof(arena_t));
+  if (arena == NULL) error_no_mem();
+
+  arena->allocator.allocate = __allocate_from_arena;
+  arena->allocator.deallocate = __deallocate_to_arena;
+  arena->allocator.data = arena;
+  arena->block_size =
+      ((block_size == ((size_t)0)) ? ARENA_DEFAULT_BLOCK_SIZE : block_size);
+  if (arena->block_size < ARENA_MIN_BLOCK_SIZE) {
+    arena->block_size = ARENA_MIN_BLOCK_SIZE;
+  }
+  arena->blocks = NULL;
+  arena->pos = NULL;
+  arena->end = NULL;
+  arena->number_bytes = (size_t)0;
+
+  return arena;
+}
+
+void delete_arena(arena_t *arena) {
+  __arena_block_t *curr, *next;
+
+  for (curr = arena->blocks; curr != NULL; curr = next) {
+    next = curr->next;
+    free(curr);
+  }
+
+  free(arena);
+}
+
+/* Allocates a block with room for size bytes. A block for a
+   large request is put behind the current block, so that the
+   rest of the current block can still be used.
+*/
+static void *__allocate_arena_block(arena_t *arena, size_t size, int own) {
+  __arena_block_t *block;
+  size_t block_size;
+
+  if (size > (SIZE_MAX - ARENA_BLOCK_HEADER)) error_no_mem();
+  block_size = ARENA_BLOCK_HEADER + size;
+
+  block = (__arena_block_t *)malloc(block_size);
+  if (block == NULL) error_no_mem();
+  block->size = block_size;
+  arena->number_bytes += block_size;
+
+  if (own && (arena->blocks != NULL)) {
+    block->next = arena->blocks->next;
+    arena->blocks->next = block;
+  } else {
+    block->next = arena->blocks;
+    arena->blocks = block;
+    if (!own) {
+      arena->pos = ((unsigned char *)block) + ARENA_BLOCK_HEADER;
+      arena->end = ((unsigned char *)block) + block_size;
+    }
+  }
+
+  return ((unsigned char *)block) + ARENA_BLOCK_HEADER;
+}
+
+/* The size of a type is a multiple of its alignment, so
+   memory of size bytes need not be aligned to more than the
+   largest power of 2 dividing size. Short strings, for
+   instance, are packed without padding.
+*/
+void *allocate_in_arena(arena_t *arena, size_t size) {
+  size_t align, pad, avail;
+  void *ptr;
+
+  if (size == ((size_t)0)) size = (size_t)1;
+  align = size & (~size + ((size_t)1));
+  if (align > ARENA_ALIGNMENT) align = ARENA_ALIGNMENT;
+  pad = ((size_t)(-(uintptr_t)arena->pos)) & (align - ((size_t)1));
+  avail = (size_t)(arena->end - arena->pos);
+
+  if ((size > avail) || (pad > (avail - size))) {
+    if (size > (arena->block_size >> 2)) {
+      return __allocate_arena_block(arena, size, 1);
+    }
+    __allocate_arena_block(arena, arena->block_size - ARENA_BLOCK_HEADER, 0);
+    pad = (size_t)0;
+  }
+
+  ptr = arena->pos + pad;
+  arena->pos += pad + size;
+
+  return ptr;
+}
+
+allocator_t *get_arena_allocator(arena_t *arena) {
+  return &(arena->allocator);
+}
+
+size_t number_bytes_in_arena(arena_t *arena) { return arena->number_bytes; }
+
+static void *__allocate_from_pool(size_t size, void *data) {
+  pool_t *pool = data;
+
+  if (size > pool->object_size) return malloc(size);
+
+  return allocate_in_pool(pool);
+}
+
+static void __deallocate_to_pool(void *ptr, size_t size, void *data) {
+  pool_t *pool = data;
+
+  if (size > pool->object_size) {
+    free(ptr);
+  } else {
+    free_in_pool(pool, ptr);
+  }
+}
+
+pool_t *create_pool(size_t object_size, size_t slab_size) {
+  pool_t *pool;
+
+  pool = (pool_t *)calloc(1, sizeof(pool_t));
+  if (pool == NULL) error_no_mem();
+
+  if (object_size < sizeof(__pool_free_block_t)) {
+    object_size = sizeof(__pool_free_block_t);
+  }
+  if (object_size > (SIZE_MAX - sizeof(void *))) error_no_mem();
+  object_size = (object_size + sizeof(void *) - ((size_t)1)) &
+                ~(sizeof(void *) - ((size_t)1));
+
+  pool->allocator.allocate = __allocate_from_pool;
+  pool->allocator.deallocate = __deallocate_to_pool;
+  pool->allocator.data = pool;
+  pool->object_size = object_size;
+  pool->slab_size =
+      ((slab_size == ((size_t)0)) ? POOL_DEFAULT_SLAB_SIZE : slab_size);
+  if (pool->slab_size < (ARENA_BLOCK_HEADER + object_size)) {
+    if (object_size > (SIZE_MAX - ARENA_BLOCK_HEADER)) error_no_mem();
+    pool->slab_size = ARENA_BLOCK_HEADER + object_size;
+  }
+  pool->slabs = NULL;
+  pool->pos = NULL;
+  pool->end = NULL;
+  pool->free_blocks = NULL;
+  pool->number_bytes = (size_t)0;
+  pool->holders = (size_t)1;
+
+  return pool;
+}
+
+void delete_pool(pool_t *pool) {
+  __arena_block_t *curr, *next;
+
+  pool->holders--;
+  if (pool->holders > ((size_t)0)) return;
+
+  for (curr = pool->slabs; curr != NULL; curr = next) {
+    next = curr->next;
+    free(curr);
+  }
+
+  free(pool);
+}
+
+pool_t *share_pool(pool_t *pool) {
+  pool->holders++;
+
+  return pool;
+}
+
+int is_shared_pool(pool_t *pool) { return (pool->holders > ((size_t)1)); }
+
+void *allocate_in_pool(pool_t *pool) {
+  __arena_block_t *slab;
+  void *ptr;
+
+  if (pool->free_blocks != NULL) {
+    ptr = pool->free_blocks;
+    pool->free_blocks = pool->free_blocks->next;
+    return ptr;
+  }
+
+  if (((size_t)(pool->end - pool->pos)) < pool->object_size) {
+    slab = (__arena_block_t *)malloc(pool->slab_size);
+    if (slab == NULL) error_no_mem();
+    slab->size = pool->slab_size;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->number_bytes += pool->slab_size;
+    pool->pos = ((unsigned char *)slab) + ARENA_BLOCK_HEADER;
+    pool->end = ((unsigned char *)slab) + pool->slab_size;
+  }
+
+  ptr = pool->pos;
+  pool->pos += pool->object_size;
+
+  return ptr;
+}
+
+void free_in_pool(pool_t *pool, void *ptr) {
+  __pool_free_block_t *block = ptr;
+
+  if (block == NULL) return;
+
+  block->next = pool->free_blocks;
+  pool->free_blocks = block;
+}
+
+allocator_t *get_pool_allocator(pool_t *pool) { return &(pool->allocator); }
+
+size_t number_bytes_in_pool(pool_t *pool) { return pool->number_bytes; }
@@ -0,0 +1,164 @@
+#ifndef __ALLOCATOR_H__
+#define __ALLOCATOR_H__
+
+#include <stdlib.h>
+
+/* An allocator hands out and takes back memory on behalf of a
+   data structure. allocate returns NULL when no memory is left;
+   deallocate is given back the size the memory has been
+   allocated with. The data pointer is given back to both
+   functions as their last argument.
+
+   Wherever an allocator_t * is taken, NULL stands for malloc
+   and free.
+*/
+typedef struct __allocator_struct_t {
+  void *(*allocate)(size_t, void *);
+  void (*deallocate)(void *, size_t, void *);
+  void *data;
+} allocator_t;
+
+/* An arena hands out memory by bumping a pointer through large
+   blocks and gives it all back at once when it is deleted.
+   Single memory blocks cannot be given back.
+*/
+typedef struct __arena_struct_t arena_t;
+
+/* A pool hands out memory blocks of one fixed size, carved out
+   of large slabs. Blocks given back are kept in a free list and
+   handed out again before the slabs grow. All slabs are given
+   back at once when the pool is deleted.
+
+   A pool may be shared by several holders, each of which
+   deletes it once it is done with it: the pool is only
+   deleted with its last holder.
+*/
+typedef struct __pool_struct_t pool_t;
+
+/* Allocate size bytes with an allocator
+
+   Exits the program if no memory is left.
+*/
+void *allocate_memory(allocator_t *allocator, size_t size);
+
+/* Allocate n zeroed elements of size bytes with an allocator
+
+   Exits the program if no memory is left.
+*/
+void *allocate_zeroed_memory(allocator_t *allocator, size_t n, size_t size);
+
+/* Give back memory of size bytes to the allocator it has been
+   allocated with. Does nothing if ptr is NULL.
+*/
+void free_memory(allocator_t *allocator, void *ptr, size_t size);
+
+/* Create an arena that reserves memory in blocks of the size
+   given in argument. Uses a default block size of 64 KiB if the
+   size in argument is zero.
+
+   O(1)
+
+   Requests larger than a quarter of the block size get a block
+   of their own, so that little memory is left unused at the end
+   of the blocks.
+*/
+arena_t *create_arena(size_t block_size);
+
+/* Delete an arena and give back all the memory allocated in it
+   at once
+
+   O(number of blocks)
+*/
+void delete_arena(arena_t *arena);
+
+/* Allocate size bytes in an arena, aligned for any type of
+   that size. The memory is not zeroed.
+
+   O(1)
+
+   Exits the program if no memory is left.
+*/
+void *allocate_in_arena(arena_t *arena, size_t size);
+
+/* Returns an allocator handing out memory from the arena. The
+   allocator lives as long as the arena. Its deallocate function
+   does nothing.
+
+   O(1)
+*/
+allocator_t *get_arena_allocator(arena_t *arena);
+
+/* Returns the number of bytes the arena has reserved from the
+   system, including the unused ends of its blocks
+
+   O(1)
+*/
+size_t number_bytes_in_arena(arena_t *arena);
+
+/* Create a pool of blocks of object_size bytes, reserving
+   memory in slabs of the size given in argument. Uses a default
+   slab size of 64 KiB if the slab size in argument is zero.
+
+   O(1)
+
+   The object size is rounded up to a multiple of the size of
+   a pointer, and the blocks are aligned to pointers.
+*/
+pool_t *create_pool(size_t object_size, size_t slab_size);
+
+/* Delete a pool and give back all its slabs at once, whether
+   their blocks have been freed or not. If the pool has been
+   shared, only drops one holder of the pool, which is deleted
+   with its last holder.
+
+   O(number of slabs)
+*/
+void delete_pool(pool_t *pool);
+
+/* Adds a holder to a pool, which then takes one more call to
+   delete_pool to be deleted. Returns the pool.
+
+   O(1)
+*/
+pool_t *share_pool(pool_t *pool);
+
+/* Returns non-zero if the pool has more than one holder, so
+   that deleting it would not give back its slabs, 0 otherwise
+
+   O(1)
+*/
+int is_shared_pool(pool_t *pool);
+
+/* Allocate a block of the object size of a pool. The memory
+   is not zeroed.
+
+   O(1)
+
+   Exits the program if no memory is left.
+*/
+void *allocate_in_pool(pool_t *pool);
+
+/* Give back a block allocated in a pool, to be handed out
+   again by the next allocation. Does nothing if ptr is NULL.
+
+   O(1)
+*/
+void free_in_pool(pool_t *pool, void *ptr);
+
+/* Returns an allocator handing out blocks of the pool for
+   requests of at most its object size, and falling back to
+   malloc and free for larger ones, such as arrays. The
+   allocator lives as long as the pool.
+
+   O(1)
+*/
+allocator_t *get_pool_allocator(pool_t *pool);
+
+/* Returns the number of bytes the pool has reserved from the
+   system, including the free blocks
+
+   O(1)
+*/
+size_t number_bytes_in_pool(pool_t *pool);
+
+#endif
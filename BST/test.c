@@ -3,15 +3,11 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "intern.h"
 #include "searchtrees.h"
 
 #define LINE_BUFFER_LEN ((size_t)4096)
 
-static void error_no_mem(void) {
-  fprintf(stderr, "Error: no memory left.\n");
-  exit(1);
-}
-
 static void input_string(char str[], size_t n) {
   char c;
   size_t i;
@@ -37,33 +33,29 @@ static void input_string(char str[], size_t n) {
   str[i] = '\0';
 }
 
-static void delete_string(void *ptr) { free(ptr); }
-
-static void delete_key(void *ptr, void *data) { delete_string(ptr); }
-
-static void delete_value(void *ptr, void *data) { delete_string(ptr); }
+/* The keys and values are interned in the pool given as the
+   data pointer, which owns them
+*/
+static void delete_key(void *ptr, void *data) {}
 
-static void *copy_string(void *ptr) {
-  char *str = ptr;
-  size_t len;
-  char *new_str;
+static void delete_value(void *ptr, void *data) {}
 
-  len = strlen(ptr);
-  len++;
+static void *copy_string(void *ptr, void *data) {
+  intern_pool_t *pool = data;
 
-  new_str = calloc(len, sizeof(char));
-  if (new_str == NULL) error_no_mem();
-
-  strcpy(new_str, str);
-
-  return new_str;
+  return (void *)intern_string(pool, ptr);
 }
 
-static void *copy_key(void *ptr, void *data) { return copy_string(ptr); }
+static void *copy_key(void *ptr, void *data) { return copy_string(ptr, data); }
 
-static void *copy_value(void *ptr, void *data) { return copy_string(ptr); }
+static void *copy_value(void *ptr, void *data) {
+  return copy_string(ptr, data);
+}
 
+/* Interned strings are equal iff they are the same pointer */
 static int compare_key(const void *ptr_a, const void *ptr_b, void *data) {
+  if (ptr_a == ptr_b) return 0;
+
   return strcmp((const char *)ptr_a, (const char *)ptr_b);
 }
 
@@ -72,8 +64,10 @@ int main(int argc, char **argv) {
   char value[LINE_BUFFER_LEN];
   char *temp_key, *temp_value;
   search_tree_t *tree;
+  intern_pool_t *pool;
 
   tree = search_tree_create();
+  pool = create_intern_pool();
 
   for (;;) {
     printf("The current search tree has %zu entries.\n",
@@ -107,7 +101,7 @@ int main(int argc, char **argv) {
           key, value, temp_value);
     } else {
       search_tree_insert(tree, key, value, compare_key, copy_key, copy_value,
-                         NULL);
+                         pool);
     }
     printf("Please enter a key to search for in the tree.\n");
     input_string(key, sizeof(key));
@@ -146,11 +140,12 @@ int main(int argc, char **argv) {
     input_string(key, sizeof(key));
     if (strcmp(key, "<nothing>") != 0) {
       search_tree_remove(tree, key, compare_key, delete_key, delete_value,
-                         NULL);
+                         pool);
     }
   }
 
-  search_tree_delete(tree, delete_key, delete_value, NULL);
+  search_tree_delete(tree, delete_key, delete_value, pool);
+  delete_intern_pool(pool);
 
   return 0;
 }
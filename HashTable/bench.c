@@ -0,0 +1,901 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "concurrenthashtable.h"
+#include "hash.h"
+#include "hashtable.h"
+#include "oahashtable.h"
+#include "rcuhashtable.h"
+#include "swisstable.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES_UNIT "cycle"
+#else
+#define CYCLES_UNIT "ns"
+#endif
+
+#define LONG_KEY_LEN ((size_t)65536)
+#define BYTES_PER_RUN (((size_t)1) << 27)
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+/* Returns the time stamp counter where available,
+   nanoseconds otherwise
+*/
+static uint64_t read_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return (uint64_t)__rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec) * ((uint64_t)1000000000) + ((uint64_t)ts.tv_nsec);
+#endif
+}
+
+static const char *hash_family_name(hash_family_t family) {
+  return ((family == HASH_FAMILY_STRONG) ? "strong" : "fast");
+}
+
+/* Hashes keys of length len taken at varying offsets of buf,
+   for a total of about BYTES_PER_RUN bytes.
+*/
+static void bench_hash_mem(const unsigned char *buf, size_t len) {
+  size_t i, n, off;
+  uint64_t start, stop;
+  uint32_t sink;
+
+  n = BYTES_PER_RUN / len;
+  sink = (uint32_t)0;
+  start = read_cycles();
+  for (i = ((size_t)0); i < n; i++) {
+    off = (i * ((size_t)7)) & ((size_t)63);
+    sink += hash_mem(&buf[off], len);
+  }
+  stop = read_cycles();
+
+  printf("  hash_mem %6s %7zu bytes: %8.3f bytes/%s, %9.2f %ss/key (%08x)\n",
+         hash_family_name(get_hash_family()), len,
+         ((double)(n * len)) / ((double)(stop - start)), CYCLES_UNIT,
+         ((double)(stop - start)) / ((double)n), CYCLES_UNIT,
+         (unsigned int)sink);
+}
+
+/* Hashes NUL-terminated strings of length len, either in a
+   single pass or with a strlen pre-scan
+*/
+static void bench_hash_str(unsigned char *buf, size_t len, int single_pass) {
+  size_t i, n, off, l;
+  uint64_t start, stop;
+  uint32_t sink;
+  unsigned char saved[64];
+
+  for (off = ((size_t)0); off < ((size_t)64); off++) {
+    saved[off] = buf[off + len];
+    buf[off + len] = (unsigned char)'\0';
+  }
+  n = BYTES_PER_RUN / (len + ((size_t)1));
+  sink = (uint32_t)0;
+  start = read_cycles();
+  for (i = ((size_t)0); i < n; i++) {
+    off = (i * ((size_t)7)) & ((size_t)63);
+    if (single_pass) {
+      sink += hash_str_len((const char *)&buf[off], &l);
+    } else {
+      l = strlen((const char *)&buf[off]);
+      sink += hash_mem(&buf[off], l);
+    }
+    sink += (uint32_t)l;
+  }
+  stop = read_cycles();
+  for (off = ((size_t)0); off < ((size_t)64); off++) {
+    buf[off + len] = saved[off];
+  }
+
+  printf("  %-15s %6s ~%3zu bytes: %9.2f %ss/key (%08x)\n",
+         (single_pass ? "hash_str_len" : "strlen+hash_mem"),
+         hash_family_name(get_hash_family()), len,
+         ((double)(stop - start)) / ((double)n), CYCLES_UNIT,
+         (unsigned int)sink);
+}
+
+static void bench_hash(void) {
+  static const size_t lens[] = {4, 8, 12, 16, 32, 64, 256, LONG_KEY_LEN};
+  static const size_t str_lens[] = {8, 16, 64};
+  static const hash_family_t families[] = {HASH_FAMILY_FAST,
+                                           HASH_FAMILY_STRONG};
+  unsigned char *buf;
+  size_t i, j;
+
+  buf = (unsigned char *)malloc(LONG_KEY_LEN + ((size_t)64));
+  if (buf == NULL) error_no_mem();
+  for (i = ((size_t)0); i < (LONG_KEY_LEN + ((size_t)64)); i++) {
+    buf[i] = (unsigned char)((i * ((size_t)131)) ^ (i >> 3));
+    if (buf[i] == ((unsigned char)0)) buf[i] = (unsigned char)1;
+  }
+
+  printf("Hash throughput:\n");
+  for (j = ((size_t)0); j < (sizeof(families) / sizeof(families[0])); j++) {
+    set_hash_family(families[j]);
+    for (i = ((size_t)0); i < (sizeof(lens) / sizeof(lens[0])); i++) {
+      bench_hash_mem(buf, lens[i]);
+    }
+    for (i = ((size_t)0); i < (sizeof(str_lens) / sizeof(str_lens[0])); i++) {
+      bench_hash_str(buf, str_lens[i], 0);
+      bench_hash_str(buf, str_lens[i], 1);
+    }
+  }
+  set_hash_family(HASH_FAMILY_FAST);
+
+  free(buf);
+}
+
+#define BATCH_KEYS ((size_t)4096)
+#define BATCH_RUNS ((size_t)2000)
+
+/* Hashes BATCH_KEYS keys BATCH_RUNS times, one at a time and
+   then through the batch functions
+*/
+static void bench_hash_batch(void) {
+  const void **ptrs;
+  size_t *lens;
+  uint64_t *keys;
+  uint32_t *hashes;
+  unsigned char *buf;
+  size_t i, r;
+  uint64_t start, mid, stop;
+  uint32_t sink;
+
+  ptrs = (const void **)calloc(BATCH_KEYS, sizeof(*ptrs));
+  lens = (size_t *)calloc(BATCH_KEYS, sizeof(*lens));
+  keys = (uint64_t *)calloc(BATCH_KEYS, sizeof(*keys));
+  hashes = (uint32_t *)calloc(BATCH_KEYS, sizeof(*hashes));
+  buf = (unsigned char *)malloc(BATCH_KEYS + ((size_t)64));
+  if ((ptrs == NULL) || (lens == NULL) || (keys == NULL) || (hashes == NULL) ||
+      (buf == NULL)) {
+    error_no_mem();
+  }
+  for (i = ((size_t)0); i < (BATCH_KEYS + ((size_t)64)); i++) {
+    buf[i] = (unsigned char)((i * ((size_t)131)) ^ (i >> 3));
+  }
+  for (i = ((size_t)0); i < BATCH_KEYS; i++) {
+    ptrs[i] = &buf[i];
+    /* Dictionary-like word lengths, 3 to 18 bytes */
+    lens[i] = ((size_t)3) + ((i * ((size_t)7)) & ((size_t)15));
+    keys[i] = ((uint64_t)i) * ((uint64_t)0x9e3779b97f4a7c15ull);
+  }
+
+  printf("Batch hashing, %zu keys:\n", BATCH_KEYS);
+
+  sink = (uint32_t)0;
+  start = read_cycles();
+  for (r = ((size_t)0); r < BATCH_RUNS; r++) {
+    for (i = ((size_t)0); i < BATCH_KEYS; i++) sink += hash_uint64(keys[i]);
+  }
+  mid = read_cycles();
+  for (r = ((size_t)0); r < BATCH_RUNS; r++) {
+    hash_uint64_batch(keys, hashes, BATCH_KEYS);
+    sink += hashes[r % BATCH_KEYS];
+  }
+  stop = read_cycles();
+  printf("  hash_uint64 %8.2f, hash_uint64_batch %8.2f %ss/key (%08x)\n",
+         ((double)(mid - start)) / ((double)(BATCH_RUNS * BATCH_KEYS)),
+         ((double)(stop - mid)) / ((double)(BATCH_RUNS * BATCH_KEYS)),
+         CYCLES_UNIT, (unsigned int)sink);
+
+  start = read_cycles();
+  for (r = ((size_t)0); r < BATCH_RUNS; r++) {
+    for (i = ((size_t)0); i < BATCH_KEYS; i++) {
+      sink += hash_mem(ptrs[i], lens[i]);
+    }
+  }
+  mid = read_cycles();
+  for (r = ((size_t)0); r < BATCH_RUNS; r++) {
+    hash_mem_batch(ptrs, lens, hashes, BATCH_KEYS);
+    sink += hashes[r % BATCH_KEYS];
+  }
+  stop = read_cycles();
+  printf("  hash_mem    %8.2f, hash_mem_batch    %8.2f %ss/key (%08x)\n",
+         ((double)(mid - start)) / ((double)(BATCH_RUNS * BATCH_KEYS)),
+         ((double)(stop - mid)) / ((double)(BATCH_RUNS * BATCH_KEYS)),
+         CYCLES_UNIT, (unsigned int)sink);
+
+  free(buf);
+  free(hashes);
+  free(keys);
+  free(lens);
+  free(ptrs);
+}
+
+#define LOOKUPS (((size_t)1) << 22)
+
+static uint32_t bench_hash_key(void *key, void *data) {
+  return hash_uint64(*((uint64_t *)key));
+}
+
+static int bench_compare_keys(void *a, void *b, void *data) {
+  return (*((uint64_t *)a) != *((uint64_t *)b));
+}
+
+static void *bench_copy(void *ptr, void *data) { return ptr; }
+
+static void bench_delete(void *ptr, void *data) {}
+
+/* Looks up LOOKUPS keys in random order in a hashtable of n
+   entries, one at a time and then with lookup_many_in_hashtable
+*/
+static void bench_lookup_size(size_t n) {
+  uint64_t *keys, *queries;
+  void **query_ptrs, **results;
+  hashtable_t *hashtable;
+  size_t i;
+  uint64_t start, mid, stop, x;
+  uintptr_t sink;
+
+  keys = (uint64_t *)calloc(n, sizeof(*keys));
+  queries = (uint64_t *)calloc(LOOKUPS, sizeof(*queries));
+  query_ptrs = (void **)calloc(LOOKUPS, sizeof(*query_ptrs));
+  results = (void **)calloc(LOOKUPS, sizeof(*results));
+  if ((keys == NULL) || (queries == NULL) || (query_ptrs == NULL) ||
+      (results == NULL)) {
+    error_no_mem();
+  }
+
+  hashtable = create_hashtable((size_t)0);
+  reserve_hashtable(hashtable, n);
+  for (i = ((size_t)0); i < n; i++) {
+    keys[i] = ((uint64_t)i) * ((uint64_t)0x9e3779b97f4a7c15ull);
+    add_to_hashtable(hashtable, &keys[i], &keys[i], bench_copy, bench_copy,
+                     bench_hash_key, NULL);
+  }
+  x = (uint64_t)1;
+  for (i = ((size_t)0); i < LOOKUPS; i++) {
+    x = x * ((uint64_t)6364136223846793005ull) + ((uint64_t)1442695040888963407ull);
+    queries[i] = keys[(size_t)((x >> 33) % ((uint64_t)n))];
+    query_ptrs[i] = &queries[i];
+  }
+
+  sink = (uintptr_t)0;
+  start = read_cycles();
+  for (i = ((size_t)0); i < LOOKUPS; i++) {
+    sink += (uintptr_t)lookup_in_hashtable(hashtable, query_ptrs[i],
+                                           bench_hash_key, bench_compare_keys,
+                                           NULL);
+  }
+  mid = read_cycles();
+  lookup_many_in_hashtable(hashtable, query_ptrs, LOOKUPS, results,
+                           bench_hash_key, bench_compare_keys, NULL);
+  stop = read_cycles();
+  for (i = ((size_t)0); i < LOOKUPS; i++) sink -= (uintptr_t)results[i];
+
+  printf("  %8zu entries: lookup %8.2f, lookup_many %8.2f %ss/key (%s)\n", n,
+         ((double)(mid - start)) / ((double)LOOKUPS),
+         ((double)(stop - mid)) / ((double)LOOKUPS), CYCLES_UNIT,
+         ((sink == ((uintptr_t)0)) ? "same results" : "DIFFERENT RESULTS"));
+
+  delete_hashtable(hashtable, bench_delete, bench_delete, NULL);
+  free(results);
+  free(query_ptrs);
+  free(queries);
+  free(keys);
+}
+
+static void bench_lookup(void) {
+  static const size_t sizes[] = {((size_t)1) << 12, ((size_t)1) << 16,
+                                 ((size_t)1) << 20, ((size_t)1) << 22};
+  size_t i;
+
+  printf("Hashtable lookups, %zu random keys:\n", LOOKUPS);
+  for (i = ((size_t)0); i < (sizeof(sizes) / sizeof(sizes[0])); i++) {
+    bench_lookup_size(sizes[i]);
+  }
+}
+
+#define SWISS_SLOTS (((size_t)1) << 20)
+
+/* Looks up LOOKUPS keys in random order, half of them present
+   and half of them absent, in a chained hashtable and a Swiss
+   table both holding load_factor * SWISS_SLOTS entries in
+   SWISS_SLOTS buckets or slots
+*/
+static void bench_swiss_load_factor(double load_factor) {
+  uint64_t *keys, *queries;
+  hashtable_t *hashtable;
+  swiss_hashtable_t *swiss_hashtable;
+  size_t i, n;
+  uint64_t start, mid, stop, x;
+  uintptr_t sink;
+
+  n = (size_t)(load_factor * ((double)SWISS_SLOTS));
+  keys = (uint64_t *)calloc(n, sizeof(*keys));
+  queries = (uint64_t *)calloc(LOOKUPS, sizeof(*queries));
+  if ((keys == NULL) || (queries == NULL)) error_no_mem();
+
+  hashtable = create_hashtable(SWISS_SLOTS);
+  swiss_hashtable = create_swiss_hashtable(n);
+  for (i = ((size_t)0); i < n; i++) {
+    keys[i] = ((uint64_t)i) * ((uint64_t)0x9e3779b97f4a7c15ull);
+    add_to_hashtable(hashtable, &keys[i], &keys[i], bench_copy, bench_copy,
+                     bench_hash_key, NULL);
+    add_to_swiss_hashtable(swiss_hashtable, &keys[i], &keys[i], bench_copy,
+                           bench_copy, bench_hash_key, NULL);
+  }
+  x = (uint64_t)1;
+  for (i = ((size_t)0); i < LOOKUPS; i++) {
+    x = x * ((uint64_t)6364136223846793005ull) + ((uint64_t)1442695040888963407ull);
+    queries[i] = keys[(size_t)((x >> 33) % ((uint64_t)n))];
+    /* Odd multiples of the key step are never added */
+    if ((x >> 32) & ((uint64_t)1)) queries[i] += (uint64_t)1;
+  }
+
+  sink = (uintptr_t)0;
+  start = read_cycles();
+  for (i = ((size_t)0); i < LOOKUPS; i++) {
+    sink += (uintptr_t)lookup_in_hashtable(hashtable, &queries[i],
+                                           bench_hash_key, bench_compare_keys,
+                                           NULL);
+  }
+  mid = read_cycles();
+  for (i = ((size_t)0); i < LOOKUPS; i++) {
+    sink -= (uintptr_t)lookup_in_swiss_hashtable(
+        swiss_hashtable, &queries[i], bench_hash_key, bench_compare_keys,
+        NULL);
+  }
+  stop = read_cycles();
+
+  printf("  load factor %5.3f: chained %8.2f, swiss %8.2f %ss/key, "
+         "%zu groups probed at most (%s)\n",
+         load_factor, ((double)(mid - start)) / ((double)LOOKUPS),
+         ((double)(stop - mid)) / ((double)LOOKUPS), CYCLES_UNIT,
+         max_number_collisions_in_swiss_hashtable(swiss_hashtable) +
+             ((size_t)1),
+         ((sink == ((uintptr_t)0)) ? "same results" : "DIFFERENT RESULTS"));
+
+  delete_swiss_hashtable(swiss_hashtable, bench_delete, bench_delete, NULL);
+  delete_hashtable(hashtable, bench_delete, bench_delete, NULL);
+  free(queries);
+  free(keys);
+}
+
+static void bench_swiss(void) {
+  static const double load_factors[] = {0.5, 0.625, 0.75, 0.875};
+  size_t i;
+
+  printf("Chained hashtable vs. Swiss table, %zu slots, %zu random keys, "
+         "half of them absent:\n",
+         SWISS_SLOTS, LOOKUPS);
+  for (i = ((size_t)0); i < (sizeof(load_factors) / sizeof(load_factors[0]));
+       i++) {
+    bench_swiss_load_factor(load_factors[i]);
+  }
+}
+
+#define FILTER_KEYS (((size_t)1) << 20)
+
+/* Looks up LOOKUPS absent keys in random order in a chained
+   hashtable of FILTER_KEYS entries, then again once a filter
+   of each false positive rate has been attached to it
+*/
+static void bench_filter(void) {
+  static const double rates[] = {0.0, 0.1, 0.01, 0.001};
+  uint64_t *keys, *queries;
+  hashtable_t *hashtable;
+  hashtable_stats_t stats;
+  size_t i, j, lookups, rejections;
+  uint64_t start, stop, x;
+  uintptr_t sink;
+
+  keys = (uint64_t *)calloc(FILTER_KEYS, sizeof(*keys));
+  queries = (uint64_t *)calloc(LOOKUPS, sizeof(*queries));
+  if ((keys == NULL) || (queries == NULL)) error_no_mem();
+
+  hashtable = create_hashtable((size_t)0);
+  reserve_hashtable(hashtable, FILTER_KEYS);
+  for (i = ((size_t)0); i < FILTER_KEYS; i++) {
+    keys[i] = ((uint64_t)i) * ((uint64_t)0x9e3779b97f4a7c15ull);
+    add_to_hashtable(hashtable, &keys[i], &keys[i], bench_copy, bench_copy,
+                     bench_hash_key, NULL);
+  }
+  x = (uint64_t)1;
+  for (i = ((size_t)0); i < LOOKUPS; i++) {
+    x = x * ((uint64_t)6364136223846793005ull) + ((uint64_t)1442695040888963407ull);
+    /* Odd multiples of the key step are never added */
+    queries[i] = keys[(size_t)((x >> 33) % ((uint64_t)FILTER_KEYS))] +
+                 ((uint64_t)1);
+  }
+
+  printf("Chained hashtable of %zu entries, %zu random absent keys:\n",
+         FILTER_KEYS, LOOKUPS);
+  for (j = ((size_t)0); j < (sizeof(rates) / sizeof(rates[0])); j++) {
+    set_hashtable_filter(hashtable, rates[j]);
+    get_hashtable_stats(hashtable, &stats);
+    lookups = stats.filter_lookups;
+    rejections = stats.filter_rejections;
+
+    sink = (uintptr_t)0;
+    start = read_cycles();
+    for (i = ((size_t)0); i < LOOKUPS; i++) {
+      sink += (uintptr_t)lookup_in_hashtable(hashtable, &queries[i],
+                                             bench_hash_key,
+                                             bench_compare_keys, NULL);
+    }
+    stop = read_cycles();
+    get_hashtable_stats(hashtable, &stats);
+
+    if (rates[j] > 0.0) {
+      printf("  filter at %6.4f: %8.2f %ss/key, %6.4f passed, "
+             "%zu bytes (%s)\n",
+             rates[j], ((double)(stop - start)) / ((double)LOOKUPS),
+             CYCLES_UNIT,
+             1.0 - ((double)(stats.filter_rejections - rejections)) /
+                       ((double)(stats.filter_lookups - lookups)),
+             stats.bytes_used,
+             ((sink == ((uintptr_t)0)) ? "none found" : "FOUND SOME"));
+    } else {
+      printf("  no filter:       %8.2f %ss/key, %zu bytes (%s)\n",
+             ((double)(stop - start)) / ((double)LOOKUPS), CYCLES_UNIT,
+             stats.bytes_used,
+             ((sink == ((uintptr_t)0)) ? "none found" : "FOUND SOME"));
+    }
+  }
+
+  delete_hashtable(hashtable, bench_delete, bench_delete, NULL);
+  free(queries);
+  free(keys);
+}
+
+#define DUPLICATE_KEYS (((size_t)1) << 16)
+
+/* Adds DUPLICATE_KEYS keys to a chained hashtable, an open
+   addressing hashtable and a Swiss table created empty, then
+   adds each key again with another value, so that both values of
+   a key go through several resizes. Counts the keys for which
+   each hashtable returns the value added last, as it should.
+*/
+static void bench_duplicates(void) {
+  uint64_t *keys, *values;
+  hashtable_t *hashtable;
+  oa_hashtable_t *oa_hashtable;
+  swiss_hashtable_t *swiss_hashtable;
+  size_t i, r, chained, open, swiss;
+  uint64_t start, stop;
+
+  keys = (uint64_t *)calloc(DUPLICATE_KEYS, sizeof(*keys));
+  values = (uint64_t *)calloc(((size_t)2) * DUPLICATE_KEYS, sizeof(*values));
+  if ((keys == NULL) || (values == NULL)) error_no_mem();
+
+  hashtable = create_hashtable((size_t)0);
+  oa_hashtable = create_oa_hashtable((size_t)0);
+  swiss_hashtable = create_swiss_hashtable((size_t)0);
+  for (i = ((size_t)0); i < DUPLICATE_KEYS; i++) {
+    keys[i] = ((uint64_t)i) * ((uint64_t)0x9e3779b97f4a7c15ull);
+  }
+  start = read_cycles();
+  for (r = ((size_t)0); r < ((size_t)2); r++) {
+    for (i = ((size_t)0); i < DUPLICATE_KEYS; i++) {
+      add_to_hashtable(hashtable, &keys[i], &values[r * DUPLICATE_KEYS + i],
+                       bench_copy, bench_copy, bench_hash_key, NULL);
+      add_to_oa_hashtable(oa_hashtable, &keys[i],
+                          &values[r * DUPLICATE_KEYS + i], bench_copy,
+                          bench_copy, bench_hash_key, NULL);
+      add_to_swiss_hashtable(swiss_hashtable, &keys[i],
+                             &values[r * DUPLICATE_KEYS + i], bench_copy,
+                             bench_copy, bench_hash_key, NULL);
+    }
+  }
+  stop = read_cycles();
+
+  chained = (size_t)0;
+  open = (size_t)0;
+  swiss = (size_t)0;
+  for (i = ((size_t)0); i < DUPLICATE_KEYS; i++) {
+    if (lookup_in_hashtable(hashtable, &keys[i], bench_hash_key,
+                            bench_compare_keys,
+                            NULL) == &values[DUPLICATE_KEYS + i]) {
+      chained++;
+    }
+    if (lookup_in_oa_hashtable(oa_hashtable, &keys[i], bench_hash_key,
+                               bench_compare_keys,
+                               NULL) == &values[DUPLICATE_KEYS + i]) {
+      open++;
+    }
+    if (lookup_in_swiss_hashtable(swiss_hashtable, &keys[i], bench_hash_key,
+                                  bench_compare_keys,
+                                  NULL) == &values[DUPLICATE_KEYS + i]) {
+      swiss++;
+    }
+  }
+
+  printf("Keys added twice across resizes, %zu keys, %8.2f %ss/add:\n",
+         DUPLICATE_KEYS,
+         ((double)(stop - start)) /
+             ((double)(((size_t)6) * DUPLICATE_KEYS)),
+         CYCLES_UNIT);
+  printf("  value added last found for chained %zu, open %zu, swiss %zu "
+         "(%s)\n",
+         chained, open, swiss,
+         (((chained == DUPLICATE_KEYS) && (open == DUPLICATE_KEYS) &&
+           (swiss == DUPLICATE_KEYS))
+              ? "same results"
+              : "DIFFERENT RESULTS"));
+
+  delete_swiss_hashtable(swiss_hashtable, bench_delete, bench_delete, NULL);
+  delete_oa_hashtable(oa_hashtable, bench_delete, bench_delete, NULL);
+  delete_hashtable(hashtable, bench_delete, bench_delete, NULL);
+  free(values);
+  free(keys);
+}
+
+#define CHAIN_KEYS (((size_t)1) << 16)
+#define CHAIN_LOAD_FACTOR (8.0)
+
+/* Draws LOOKUPS keys among n following a Zipf distribution of
+   exponent 1, the rank r key being looked up with a probability
+   proportional to 1 / r. The ranks are spread over the keys by
+   an odd multiplier, n being a power of 2.
+*/
+static void draw_zipf_queries(uint64_t *keys, size_t n, uint64_t *queries) {
+  double *cdf;
+  double u;
+  size_t i, lo, hi, mid;
+  uint64_t x;
+
+  cdf = (double *)calloc(n, sizeof(*cdf));
+  if (cdf == NULL) error_no_mem();
+
+  cdf[0] = 1.0;
+  for (i = ((size_t)1); i < n; i++) {
+    cdf[i] = cdf[i - ((size_t)1)] + 1.0 / ((double)(i + ((size_t)1)));
+  }
+
+  x = (uint64_t)1;
+  for (i = ((size_t)0); i < LOOKUPS; i++) {
+    x = x * ((uint64_t)6364136223846793005ull) + ((uint64_t)1442695040888963407ull);
+    u = (((double)(x >> 11)) / 9007199254740992.0) * cdf[n - ((size_t)1)];
+    lo = (size_t)0;
+    hi = n - ((size_t)1);
+    while (lo < hi) {
+      mid = lo + ((hi - lo) >> 1);
+      if (cdf[mid] < u) {
+        lo = mid + ((size_t)1);
+      } else {
+        hi = mid;
+      }
+    }
+    queries[i] = keys[(lo * ((size_t)0x9e3779b1u)) & (n - ((size_t)1))];
+  }
+
+  free(cdf);
+}
+
+/* Looks up LOOKUPS keys drawn from a Zipf distribution in a
+   chained hashtable of CHAIN_KEYS entries and CHAIN_LOAD_FACTOR
+   entries per bucket, built anew for each chain order
+*/
+static void bench_chains(void) {
+  static const hashtable_chain_order_t orders[] = {
+      HASHTABLE_CHAIN_ORDER_FIXED, HASHTABLE_CHAIN_ORDER_MOVE_TO_FRONT,
+      HASHTABLE_CHAIN_ORDER_TRANSPOSE};
+  static const char *const names[] = {"fixed", "move-to-front", "transpose"};
+  uint64_t *keys, *queries;
+  hashtable_t *hashtable;
+  hashtable_stats_t stats;
+  size_t i, j;
+  uint64_t start, stop;
+  uintptr_t sink, expected;
+
+  keys = (uint64_t *)calloc(CHAIN_KEYS, sizeof(*keys));
+  queries = (uint64_t *)calloc(LOOKUPS, sizeof(*queries));
+  if ((keys == NULL) || (queries == NULL)) error_no_mem();
+
+  for (i = ((size_t)0); i < CHAIN_KEYS; i++) {
+    keys[i] = ((uint64_t)i) * ((uint64_t)0x9e3779b97f4a7c15ull);
+  }
+  draw_zipf_queries(keys, CHAIN_KEYS, queries);
+  expected = (uintptr_t)0;
+  for (i = ((size_t)0); i < LOOKUPS; i++) expected += (uintptr_t)queries[i];
+
+  printf("Chained hashtable of %zu entries at load factor %.1f, %zu "
+         "Zipf distributed keys:\n",
+         CHAIN_KEYS, CHAIN_LOAD_FACTOR, LOOKUPS);
+  for (j = ((size_t)0); j < (sizeof(orders) / sizeof(orders[0])); j++) {
+    hashtable = create_hashtable((size_t)0);
+    set_hashtable_load_factor(hashtable, CHAIN_LOAD_FACTOR);
+    reserve_hashtable(hashtable, CHAIN_KEYS);
+    for (i = ((size_t)0); i < CHAIN_KEYS; i++) {
+      add_to_hashtable(hashtable, &keys[i], &keys[i], bench_copy, bench_copy,
+                       bench_hash_key, NULL);
+    }
+    set_hashtable_chain_order(hashtable, orders[j]);
+    set_hashtable_lookup_counting(hashtable, 1);
+
+    sink = (uintptr_t)0;
+    start = read_cycles();
+    for (i = ((size_t)0); i < LOOKUPS; i++) {
+      sink += (uintptr_t)(*((uint64_t *)lookup_in_hashtable(
+          hashtable, &queries[i], bench_hash_key, bench_compare_keys, NULL)));
+    }
+    stop = read_cycles();
+    get_hashtable_stats(hashtable, &stats);
+
+    printf("  %-13s: %8.2f %ss/key, %5.2f comparisons/lookup (%s)\n",
+           names[j], ((double)(stop - start)) / ((double)LOOKUPS), CYCLES_UNIT,
+           ((double)stats.lookup_comparisons) / ((double)stats.lookups),
+           ((sink == expected) ? "same results" : "DIFFERENT RESULTS"));
+
+    delete_hashtable(hashtable, bench_delete, bench_delete, NULL);
+  }
+
+  free(queries);
+  free(keys);
+}
+
+#define CONCURRENT_KEYS (((size_t)1) << 20)
+#define CONCURRENT_OPS (((size_t)1) << 21)
+
+static double read_seconds(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((double)ts.tv_sec) + ((double)ts.tv_nsec) * 1e-9;
+}
+
+/* One benchmark thread. With a concurrent or read-optimized
+   hashtable, uses it; otherwise uses hashtable behind a single
+   global mutex.
+*/
+typedef enum {
+  TABLE_GLOBAL_MUTEX,
+  TABLE_LOCK_STRIPED,
+  TABLE_RCU
+} concurrent_table_t;
+
+typedef struct {
+  rcu_hashtable_t *rcu_hashtable;
+  concurrent_hashtable_t *concurrent_hashtable;
+  hashtable_t *hashtable;
+  pthread_mutex_t *mutex;
+  uint64_t *keys;
+  uint64_t seed;
+  size_t found;
+} concurrent_worker_t;
+
+/* 90% lookups, 5% adds and 5% removes of random keys */
+static void *concurrent_worker(void *arg) {
+  concurrent_worker_t *worker = arg;
+  size_t i, op;
+  uint64_t x;
+  void *key;
+  epoch_reader_t *reader;
+
+  reader = NULL;
+  if (worker->rcu_hashtable != NULL) {
+    reader = register_rcu_hashtable_reader(worker->rcu_hashtable);
+  }
+  x = worker->seed;
+  for (i = ((size_t)0); i < CONCURRENT_OPS; i++) {
+    x = x * ((uint64_t)6364136223846793005ull) + ((uint64_t)1442695040888963407ull);
+    key = &(worker->keys[(size_t)((x >> 33) % ((uint64_t)CONCURRENT_KEYS))]);
+    op = (size_t)((x >> 20) % ((uint64_t)20));
+    if (worker->rcu_hashtable != NULL) {
+      if (op == ((size_t)0)) {
+        add_to_rcu_hashtable(worker->rcu_hashtable, key, key, bench_copy,
+                             bench_copy, bench_hash_key, NULL);
+      } else if (op == ((size_t)1)) {
+        remove_from_rcu_hashtable(worker->rcu_hashtable, key, bench_hash_key,
+                                  bench_compare_keys, bench_delete,
+                                  bench_delete, NULL);
+      } else {
+        enter_epoch(reader);
+        if (lookup_in_rcu_hashtable(worker->rcu_hashtable, key,
+                                    bench_hash_key, bench_compare_keys,
+                                    NULL) != NULL) {
+          worker->found++;
+        }
+        exit_epoch(reader);
+      }
+    } else if (worker->concurrent_hashtable != NULL) {
+      if (op == ((size_t)0)) {
+        add_to_concurrent_hashtable(worker->concurrent_hashtable, key, key,
+                                    bench_copy, bench_copy, bench_hash_key,
+                                    NULL);
+      } else if (op == ((size_t)1)) {
+        remove_from_concurrent_hashtable(worker->concurrent_hashtable, key,
+                                         bench_hash_key, bench_compare_keys,
+                                         bench_delete, bench_delete, NULL);
+      } else if (lookup_in_concurrent_hashtable(
+                     worker->concurrent_hashtable, key, bench_hash_key,
+                     bench_compare_keys, NULL) != NULL) {
+        worker->found++;
+      }
+    } else {
+      pthread_mutex_lock(worker->mutex);
+      if (op == ((size_t)0)) {
+        add_to_hashtable(worker->hashtable, key, key, bench_copy, bench_copy,
+                         bench_hash_key, NULL);
+      } else if (op == ((size_t)1)) {
+        remove_from_hashtable(worker->hashtable, key, bench_hash_key,
+                              bench_compare_keys, bench_delete, bench_delete,
+                              NULL);
+      } else if (lookup_in_hashtable(worker->hashtable, key, bench_hash_key,
+                                     bench_compare_keys, NULL) != NULL) {
+        worker->found++;
+      }
+      pthread_mutex_unlock(worker->mutex);
+    }
+  }
+  if (reader != NULL) {
+    unregister_rcu_hashtable_reader(worker->rcu_hashtable, reader);
+  }
+
+  return NULL;
+}
+
+static double bench_concurrent_run(uint64_t *keys, size_t nthreads,
+                                   concurrent_table_t type) {
+  rcu_hashtable_t *rcu_hashtable;
+  concurrent_hashtable_t *concurrent_hashtable;
+  hashtable_t *hashtable;
+  pthread_mutex_t mutex;
+  concurrent_worker_t *workers;
+  pthread_t *threads;
+  size_t i;
+  double start, stop;
+
+  rcu_hashtable = NULL;
+  concurrent_hashtable = NULL;
+  hashtable = NULL;
+  switch (type) {
+    case TABLE_RCU:
+      rcu_hashtable = create_rcu_hashtable((size_t)0);
+      break;
+    case TABLE_LOCK_STRIPED:
+      concurrent_hashtable =
+          create_concurrent_hashtable((size_t)0, (size_t)0);
+      break;
+    default:
+      hashtable = create_hashtable((size_t)0);
+      break;
+  }
+  pthread_mutex_init(&mutex, NULL);
+  for (i = ((size_t)0); i < CONCURRENT_KEYS; i += ((size_t)2)) {
+    if (rcu_hashtable != NULL) {
+      add_to_rcu_hashtable(rcu_hashtable, &keys[i], &keys[i], bench_copy,
+                           bench_copy, bench_hash_key, NULL);
+    } else if (concurrent_hashtable != NULL) {
+      add_to_concurrent_hashtable(concurrent_hashtable, &keys[i], &keys[i],
+                                  bench_copy, bench_copy, bench_hash_key,
+                                  NULL);
+    } else {
+      add_to_hashtable(hashtable, &keys[i], &keys[i], bench_copy, bench_copy,
+                       bench_hash_key, NULL);
+    }
+  }
+
+  workers = (concurrent_worker_t *)calloc(nthreads, sizeof(*workers));
+  threads = (pthread_t *)calloc(nthreads, sizeof(*threads));
+  if ((workers == NULL) || (threads == NULL)) error_no_mem();
+
+  start = read_seconds();
+  for (i = ((size_t)0); i < nthreads; i++) {
+    workers[i].rcu_hashtable = rcu_hashtable;
+    workers[i].concurrent_hashtable = concurrent_hashtable;
+    workers[i].hashtable = hashtable;
+    workers[i].mutex = &mutex;
+    workers[i].keys = keys;
+    workers[i].seed = ((uint64_t)i) + ((uint64_t)1);
+    if (pthread_create(&threads[i], NULL, concurrent_worker, &workers[i]) !=
+        0) {
+      fprintf(stderr, "Could not create thread\n");
+      exit(1);
+    }
+  }
+  for (i = ((size_t)0); i < nthreads; i++) pthread_join(threads[i], NULL);
+  stop = read_seconds();
+
+  if (rcu_hashtable != NULL) {
+    delete_rcu_hashtable(rcu_hashtable, bench_delete, bench_delete, NULL);
+  } else if (concurrent_hashtable != NULL) {
+    delete_concurrent_hashtable(concurrent_hashtable, bench_delete,
+                                bench_delete, NULL);
+  } else {
+    delete_hashtable(hashtable, bench_delete, bench_delete, NULL);
+  }
+  pthread_mutex_destroy(&mutex);
+  free(threads);
+  free(workers);
+
+  return ((double)(nthreads * CONCURRENT_OPS)) / (stop - start) * 1e-6;
+}
+
+static void bench_concurrent(void) {
+  uint64_t *keys;
+  size_t i, nthreads, ncpus;
+  long n;
+
+  keys = (uint64_t *)calloc(CONCURRENT_KEYS, sizeof(*keys));
+  if (keys == NULL) error_no_mem();
+  for (i = ((size_t)0); i < CONCURRENT_KEYS; i++) {
+    keys[i] = ((uint64_t)i) * ((uint64_t)0x9e3779b97f4a7c15ull);
+  }
+  n = sysconf(_SC_NPROCESSORS_ONLN);
+  ncpus = ((n < 1L) ? ((size_t)1) : ((size_t)n));
+
+  printf("Concurrent hashtable, 90%% lookups, 5%% adds, 5%% removes, "
+         "%zu cpus:\n",
+         ncpus);
+  for (nthreads = ((size_t)1);; nthreads <<= 1) {
+    if (nthreads > ncpus) nthreads = ncpus;
+    printf("  %3zu threads: global mutex %7.2f, lock-striped %7.2f, "
+           "rcu %7.2f Mops/s\n",
+           nthreads, bench_concurrent_run(keys, nthreads, TABLE_GLOBAL_MUTEX),
+           bench_concurrent_run(keys, nthreads, TABLE_LOCK_STRIPED),
+           bench_concurrent_run(keys, nthreads, TABLE_RCU));
+    if (nthreads >= ncpus) break;
+  }
+
+  free(keys);
+}
+
+static const char *const sections[] = {
+    "hash",   "batch",      "lookup", "swiss",
+    "filter", "duplicates", "chains", "concurrent"};
+
+/* Returns non-zero if the section has been asked for on the
+   command line, or if no section has been asked for at all
+*/
+static int selected(int argc, char **argv, const char *section) {
+  int i;
+
+  if (argc < 2) return 1;
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], section) == 0) return 1;
+  }
+
+  return 0;
+}
+
+static void usage(const char *name) {
+  size_t i;
+
+  fprintf(stderr, "Usage: %s [section ...]\nSections:", name);
+  for (i = ((size_t)0); i < (sizeof(sections) / sizeof(sections[0])); i++) {
+    fprintf(stderr, " %s", sections[i]);
+  }
+  fprintf(stderr, "\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  int i;
+  size_t j;
+
+  for (i = 1; i < argc; i++) {
+    for (j = ((size_t)0); j < (sizeof(sections) / sizeof(sections[0])); j++) {
+      if (strcmp(argv[i], sections[j]) == 0) break;
+    }
+    if (j >= (sizeof(sections) / sizeof(sections[0]))) {
+      usage((argc > 0) ? argv[0] : "bench");
+    }
+  }
+
+  if (selected(argc, argv, "hash")) bench_hash();
+  if (selected(argc, argv, "batch")) bench_hash_batch();
+  if (selected(argc, argv, "lookup")) bench_lookup();
+  if (selected(argc, argv, "swiss")) bench_swiss();
+  if (selected(argc, argv, "filter")) bench_filter();
+  if (selected(argc, argv, "duplicates")) bench_duplicates();
+  if (selected(argc, argv, "chains")) bench_chains();
+  if (selected(argc, argv, "concurrent")) bench_concurrent();
+
+  return 0;
+}
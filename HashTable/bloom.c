@@ -0,0 +1,179 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "bloom.h"
+#include "hash.h"
+
+#define BLOOM_BLOCK_BITS ((size_t)512)
+#define BLOOM_BLOCK_WORDS (BLOOM_BLOCK_BITS / ((size_t)64))
+#define BLOOM_BLOCK_BYTES (BLOOM_BLOCK_BITS / ((size_t)8))
+#define BLOOM_MAX_K ((size_t)16)
+/* 1 / ln 2 */
+#define BLOOM_BITS_PER_K (1.4426950408889634)
+/* Set in the high half of the input of the second derived
+   hash, so that it differs from the first one
+*/
+#define BLOOM_SEED ((uint64_t)(0x85ebca6bull))
+
+#if defined(__GNUC__)
+#define PREFETCH(p) __builtin_prefetch((p), 0, 3)
+#else
+#define PREFETCH(p) ((void)(p))
+#endif
+
+/* blocks is memory aligned to a cache line within memory,
+   which has been allocated with memory_len bytes
+*/
+struct __bloom_filter_struct_t {
+  allocator_t *allocator;
+  size_t k;
+  size_t capacity;
+  size_t number_keys;
+  size_t number_blocks;
+  void *memory;
+  size_t memory_len;
+  uint64_t *blocks;
+  atomic_size_t lookups;
+  atomic_size_t rejections;
+};
+
+static void __alloc_bloom_filter_blocks(bloom_filter_t *filter,
+                                        size_t capacity) {
+  size_t number_bits;
+
+  number_bits = (size_t)(((double)capacity) * ((double)filter->k) *
+                         BLOOM_BITS_PER_K);
+  filter->capacity = capacity;
+  filter->number_keys = (size_t)0;
+  filter->number_blocks = (number_bits / BLOOM_BLOCK_BITS) + ((size_t)1);
+  filter->memory_len =
+      (filter->number_blocks + ((size_t)1)) * BLOOM_BLOCK_BYTES;
+  filter->memory = allocate_memory(filter->allocator, filter->memory_len);
+  filter->blocks =
+      (uint64_t *)((((uintptr_t)filter->memory) +
+                    ((uintptr_t)(BLOOM_BLOCK_BYTES - ((size_t)1)))) &
+                   ~((uintptr_t)(BLOOM_BLOCK_BYTES - ((size_t)1))));
+  memset(filter->blocks, 0, filter->number_blocks * BLOOM_BLOCK_BYTES);
+}
+
+bloom_filter_t *create_bloom_filter(size_t capacity,
+                                    double false_positive_rate,
+                                    allocator_t *allocator) {
+  bloom_filter_t *filter;
+  double rate;
+
+  filter = (bloom_filter_t *)allocate_zeroed_memory(allocator, 1,
+                                                    sizeof(bloom_filter_t));
+  filter->allocator = allocator;
+
+  /* Smallest k such that 2^-k is at most the rate */
+  filter->k = (size_t)1;
+  for (rate = 0.5; (rate > false_positive_rate) && (filter->k < BLOOM_MAX_K);
+       rate *= 0.5) {
+    filter->k++;
+  }
+  atomic_init(&(filter->lookups), (size_t)0);
+  atomic_init(&(filter->rejections), (size_t)0);
+
+  __alloc_bloom_filter_blocks(filter, capacity);
+
+  return filter;
+}
+
+void delete_bloom_filter(bloom_filter_t *filter) {
+  allocator_t *allocator;
+
+  allocator = filter->allocator;
+  free_memory(allocator, filter->memory, filter->memory_len);
+  free_memory(allocator, filter, sizeof(bloom_filter_t));
+}
+
+void resize_bloom_filter(bloom_filter_t *filter, size_t capacity) {
+  free_memory(filter->allocator, filter->memory, filter->memory_len);
+  __alloc_bloom_filter_blocks(filter, capacity);
+}
+
+/* Returns the block of a hash and the first bit and the odd
+   step of the bits it sets within that block
+*/
+static uint64_t *__bloom_filter_block(bloom_filter_t *filter, uint32_t hash,
+                                      size_t *bit, size_t *step) {
+  uint32_t a, b;
+  size_t i;
+
+  a = hash_uint64((uint64_t)hash);
+  b = hash_uint64(((uint64_t)hash) | (BLOOM_SEED << 32));
+
+  i = (size_t)((((uint64_t)a) * ((uint64_t)filter->number_blocks)) >> 32);
+  *bit = ((size_t)b) & (BLOOM_BLOCK_BITS - ((size_t)1));
+  *step = (((size_t)(b >> 9)) & (BLOOM_BLOCK_BITS - ((size_t)1))) | ((size_t)1);
+
+  return &(filter->blocks[i * BLOOM_BLOCK_WORDS]);
+}
+
+void add_to_bloom_filter(bloom_filter_t *filter, uint32_t hash) {
+  uint64_t *block;
+  size_t bit, step, i;
+
+  block = __bloom_filter_block(filter, hash, &bit, &step);
+  for (i = ((size_t)0); i < filter->k; i++) {
+    block[bit >> 6] |= ((uint64_t)1) << (bit & ((size_t)63));
+    bit = (bit + step) & (BLOOM_BLOCK_BITS - ((size_t)1));
+  }
+  filter->number_keys++;
+}
+
+/* Adds one to a counter that only the lookups change, which
+   several readers may change at the same time
+*/
+static void __count_bloom_filter_lookup(atomic_size_t *counter) {
+  atomic_fetch_add_explicit(counter, (size_t)1, memory_order_relaxed);
+}
+
+int lookup_in_bloom_filter(bloom_filter_t *filter, uint32_t hash) {
+  const uint64_t *block;
+  size_t bit, step, i;
+
+  __count_bloom_filter_lookup(&(filter->lookups));
+
+  block = __bloom_filter_block(filter, hash, &bit, &step);
+  for (i = ((size_t)0); i < filter->k; i++) {
+    if (((block[bit >> 6] >> (bit & ((size_t)63))) & ((uint64_t)1)) ==
+        ((uint64_t)0)) {
+      __count_bloom_filter_lookup(&(filter->rejections));
+      return 0;
+    }
+    bit = (bit + step) & (BLOOM_BLOCK_BITS - ((size_t)1));
+  }
+
+  return 1;
+}
+
+void prefetch_in_bloom_filter(bloom_filter_t *filter, uint32_t hash) {
+  size_t bit, step;
+
+  PREFETCH(__bloom_filter_block(filter, hash, &bit, &step));
+}
+
+size_t number_keys_in_bloom_filter(bloom_filter_t *filter) {
+  return filter->number_keys;
+}
+
+size_t capacity_of_bloom_filter(bloom_filter_t *filter) {
+  return filter->capacity;
+}
+
+size_t number_bytes_in_bloom_filter(bloom_filter_t *filter) {
+  return sizeof(bloom_filter_t) + filter->memory_len;
+}
+
+size_t number_lookups_in_bloom_filter(bloom_filter_t *filter,
+                                      size_t *rejected) {
+  *rejected = atomic_load_explicit(&(filter->rejections), memory_order_relaxed);
+
+  return atomic_load_explicit(&(filter->lookups), memory_order_relaxed);
+}
@@ -0,0 +1,106 @@
+#ifndef __BLOOM_H__
+#define __BLOOM_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "allocator.h"
+
+/* A blocked Bloom filter tells whether a key may have been
+   added to it, from the 32-bit hash of the key. It never
+   answers no for an added key, and answers yes for a key that
+   has not been added with about the false positive rate it has
+   been created with, as long as no more keys than its capacity
+   have been added.
+
+   Each key sets k bits within a single block of 512 bits, a
+   cache line, so that a lookup reads one cache line. Two hashes
+   are derived from the hash of the key with hash_uint64: one
+   chooses the block, the other the k bits within it by double
+   hashing. With k = log2(1 / false positive rate), the filter
+   takes k / ln 2 bits per key. Blocking makes the actual false
+   positive rate slightly higher than that of a plain Bloom
+   filter of the same size.
+
+   Keys cannot be removed. The filter counts its lookups and
+   the lookups it has answered no to, with relaxed atomic
+   additions: the counts stay exact when several threads look
+   up at the same time.
+*/
+typedef struct __bloom_filter_struct_t bloom_filter_t;
+
+/* Creates an empty blocked Bloom filter for capacity keys at
+   the given false positive rate, allocated with the allocator
+   in argument. The allocator must outlive the filter.
+
+   O(capacity)
+
+   The false positive rate is taken to be 1/2 if it is larger,
+   and 2^-16 if it is smaller.
+*/
+bloom_filter_t *create_bloom_filter(size_t capacity,
+                                    double false_positive_rate,
+                                    allocator_t *allocator);
+
+/* Deletes a blocked Bloom filter
+
+   O(1)
+*/
+void delete_bloom_filter(bloom_filter_t *filter);
+
+/* Empties a blocked Bloom filter and sizes it for capacity
+   keys at its false positive rate. Keeps the lookup counts.
+
+   O(capacity)
+*/
+void resize_bloom_filter(bloom_filter_t *filter, size_t capacity);
+
+/* Adds the hash of a key to a blocked Bloom filter
+
+   O(1)
+*/
+void add_to_bloom_filter(bloom_filter_t *filter, uint32_t hash);
+
+/* Returns 0 if the key of the hash in argument has not been
+   added to the blocked Bloom filter, non-zero if it may have
+   been.
+
+   O(1)
+*/
+int lookup_in_bloom_filter(bloom_filter_t *filter, uint32_t hash);
+
+/* Prefetches the block a lookup of the hash in argument reads
+
+   O(1)
+*/
+void prefetch_in_bloom_filter(bloom_filter_t *filter, uint32_t hash);
+
+/* Returns the number of keys added since the blocked Bloom
+   filter has been created or resized
+
+   O(1)
+*/
+size_t number_keys_in_bloom_filter(bloom_filter_t *filter);
+
+/* Returns the number of keys the blocked Bloom filter has
+   been sized for
+
+   O(1)
+*/
+size_t capacity_of_bloom_filter(bloom_filter_t *filter);
+
+/* Returns the number of bytes of the blocked Bloom filter
+
+   O(1)
+*/
+size_t number_bytes_in_bloom_filter(bloom_filter_t *filter);
+
+/* Returns the number of lookups in the blocked Bloom filter
+   and stores the number of them answered with 0 in rejected
+
+   O(1)
+*/
+size_t number_lookups_in_bloom_filter(bloom_filter_t *filter,
+                                      size_t *rejected);
+
+#endif
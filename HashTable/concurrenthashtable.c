@@ -0,0 +1,188 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "concurrenthashtable.h"
+#include "hashtable.h"
+
+/* The padding keeps the locks of neighbouring segments,
+   which are written by every reader, out of each other's
+   cache line
+*/
+struct __concurrent_hashtable_segment_struct_t {
+  pthread_rwlock_t lock;
+  hashtable_t *hashtable;
+  char padding[64];
+};
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+concurrent_hashtable_t *create_concurrent_hashtable(size_t size,
+                                                    size_t number_segments) {
+  concurrent_hashtable_t *hashtable;
+  size_t i, n;
+  unsigned int bits;
+
+  if (number_segments == ((size_t)0)) {
+    number_segments = CONCURRENT_HASHTABLE_DEFAULT_SEGMENTS;
+  }
+  n = (size_t)1;
+  bits = 0u;
+  while ((n < number_segments) && (bits < 16u)) {
+    n <<= 1;
+    bits++;
+  }
+
+  hashtable =
+      (concurrent_hashtable_t *)calloc(1, sizeof(concurrent_hashtable_t));
+  if (hashtable == NULL) error_no_mem();
+
+  hashtable->number_segments = n;
+  hashtable->segment_shift = 32u - bits;
+  hashtable->segments = (concurrent_hashtable_segment_t *)calloc(
+      n, sizeof(concurrent_hashtable_segment_t));
+  if (hashtable->segments == NULL) error_no_mem();
+
+  for (i = ((size_t)0); i < n; i++) {
+    if (pthread_rwlock_init(&(hashtable->segments[i].lock), NULL) != 0) {
+      error_no_mem();
+    }
+    hashtable->segments[i].hashtable = create_hashtable(size / n);
+  }
+
+  return hashtable;
+}
+
+void delete_concurrent_hashtable(concurrent_hashtable_t *hashtable,
+                                 void (*delete_key)(void *, void *),
+                                 void (*delete_value)(void *, void *),
+                                 void *data) {
+  size_t i;
+
+  for (i = ((size_t)0); i < hashtable->number_segments; i++) {
+    delete_hashtable(hashtable->segments[i].hashtable, delete_key,
+                     delete_value, data);
+    pthread_rwlock_destroy(&(hashtable->segments[i].lock));
+  }
+
+  free(hashtable->segments);
+  free(hashtable);
+}
+
+/* The top bits of the hash pick the segment, the hashtable of
+   the segment uses all bits to pick the bucket. Shifting a
+   64-bit value lets a single segment have a shift of 32.
+*/
+static concurrent_hashtable_segment_t *__concurrent_hashtable_segment(
+    concurrent_hashtable_t *hashtable, uint32_t hash) {
+  return &(hashtable->segments[(size_t)(((uint64_t)hash) >>
+                                        hashtable->segment_shift)]);
+}
+
+void *lookup_in_concurrent_hashtable(concurrent_hashtable_t *hashtable,
+                                     void *key,
+                                     uint32_t (*hash_key)(void *, void *),
+                                     int (*compare_keys)(void *, void *,
+                                                         void *),
+                                     void *data) {
+  uint32_t hash;
+  concurrent_hashtable_segment_t *segment;
+  void *value;
+
+  hash = hash_key(key, data);
+  segment = __concurrent_hashtable_segment(hashtable, hash);
+
+  pthread_rwlock_rdlock(&(segment->lock));
+  value = lookup_hashed_in_hashtable(segment->hashtable, key, hash,
+                                     compare_keys, data);
+  pthread_rwlock_unlock(&(segment->lock));
+
+  return value;
+}
+
+void add_to_concurrent_hashtable(concurrent_hashtable_t *hashtable, void *key,
+                                 void *value,
+                                 void *(*copy_key)(void *, void *),
+                                 void *(*copy_value)(void *, void *),
+                                 uint32_t (*hash_key)(void *, void *),
+                                 void *data) {
+  uint32_t hash;
+  concurrent_hashtable_segment_t *segment;
+
+  hash = hash_key(key, data);
+  segment = __concurrent_hashtable_segment(hashtable, hash);
+
+  pthread_rwlock_wrlock(&(segment->lock));
+  add_hashed_to_hashtable(segment->hashtable, key, value, hash, copy_key,
+                          copy_value, data);
+  pthread_rwlock_unlock(&(segment->lock));
+}
+
+void remove_from_concurrent_hashtable(
+    concurrent_hashtable_t *hashtable, void *key,
+    uint32_t (*hash_key)(void *, void *),
+    int (*compare_keys)(void *, void *, void *),
+    void (*delete_key)(void *, void *), void (*delete_value)(void *, void *),
+    void *data) {
+  uint32_t hash;
+  concurrent_hashtable_segment_t *segment;
+
+  hash = hash_key(key, data);
+  segment = __concurrent_hashtable_segment(hashtable, hash);
+
+  pthread_rwlock_wrlock(&(segment->lock));
+  remove_hashed_from_hashtable(segment->hashtable, key, hash, compare_keys,
+                               delete_key, delete_value, data);
+  pthread_rwlock_unlock(&(segment->lock));
+}
+
+void reserve_concurrent_hashtable(concurrent_hashtable_t *hashtable,
+                                  size_t number_entries) {
+  size_t i, n;
+  concurrent_hashtable_segment_t *segment;
+
+  n = (number_entries / hashtable->number_segments) + ((size_t)1);
+  for (i = ((size_t)0); i < hashtable->number_segments; i++) {
+    segment = &(hashtable->segments[i]);
+    pthread_rwlock_wrlock(&(segment->lock));
+    reserve_hashtable(segment->hashtable, n);
+    pthread_rwlock_unlock(&(segment->lock));
+  }
+}
+
+size_t number_entries_in_concurrent_hashtable(
+    concurrent_hashtable_t *hashtable) {
+  size_t i, n;
+  concurrent_hashtable_segment_t *segment;
+
+  n = (size_t)0;
+  for (i = ((size_t)0); i < hashtable->number_segments; i++) {
+    segment = &(hashtable->segments[i]);
+    pthread_rwlock_rdlock(&(segment->lock));
+    n += number_entries_in_hashtable(segment->hashtable);
+    pthread_rwlock_unlock(&(segment->lock));
+  }
+
+  return n;
+}
+
+size_t max_number_collisions_in_concurrent_hashtable(
+    concurrent_hashtable_t *hashtable) {
+  size_t i, k, l;
+  concurrent_hashtable_segment_t *segment;
+
+  k = (size_t)0;
+  for (i = ((size_t)0); i < hashtable->number_segments; i++) {
+    segment = &(hashtable->segments[i]);
+    pthread_rwlock_rdlock(&(segment->lock));
+    l = max_number_collisions_in_hashtable(segment->hashtable);
+    pthread_rwlock_unlock(&(segment->lock));
+    if (l > k) k = l;
+  }
+
+  return k;
+}
@@ -0,0 +1,139 @@
+#ifndef __CONCURRENT_HASHTABLE_H__
+#define __CONCURRENT_HASHTABLE_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "hashtable.h"
+
+typedef struct __concurrent_hashtable_segment_struct_t
+    concurrent_hashtable_segment_t;
+
+/* A hashtable that can be used by several threads at once.
+
+   The entries are split by the top bits of their hash into a
+   power of 2 of segments. Each segment is a hashtable_t of its
+   own, guarded by a readers-writer lock, so that lookups only
+   ever wait for a writer of the same segment and writers of
+   different segments do not wait for each other. Each segment
+   resizes incrementally under its own lock, blocking only its
+   own readers and writers while it does.
+*/
+typedef struct __concurrent_hashtable_struct_t {
+  size_t number_segments;
+  unsigned int segment_shift;
+  concurrent_hashtable_segment_t *segments;
+} concurrent_hashtable_t;
+
+/* Default number of segments of a concurrent hashtable */
+#define CONCURRENT_HASHTABLE_DEFAULT_SEGMENTS ((size_t)64)
+
+/* Create a concurrent hashtable of about the size given in
+   argument, split into the number of segments given in
+   argument, rounded up to a power of 2. Uses
+   CONCURRENT_HASHTABLE_DEFAULT_SEGMENTS segments if the number
+   in argument is zero.
+
+   O(n)
+
+   A few segments per thread are enough to make it unlikely
+   that two threads need the same segment.
+*/
+concurrent_hashtable_t *create_concurrent_hashtable(size_t size,
+                                                    size_t number_segments);
+
+/* Delete a concurrent hashtable. Calls delete_key for each key
+   and calls delete_value for each value. No other thread may
+   use the hashtable any longer.
+
+   O(n)
+
+   The data pointer is given back to the delete_key
+   and delete_value functions as their last argument.
+*/
+void delete_concurrent_hashtable(concurrent_hashtable_t *hashtable,
+                                 void (*delete_key)(void *, void *),
+                                 void (*delete_value)(void *, void *),
+                                 void *data);
+
+/* Lookup a key in a concurrent hashtable, as lookup_in_hashtable
+   does. Takes the read lock of one segment.
+
+   O(1) if no collision, O(n) if collisions.
+
+   The returned value is the copy held in the hashtable. It
+   stays valid only as long as no thread removes it from the
+   hashtable.
+
+   The data pointer is given back to the hash_key and
+   compare_keys functions as their last argument. These
+   functions may be called by several threads at once.
+*/
+void *lookup_in_concurrent_hashtable(concurrent_hashtable_t *hashtable,
+                                     void *key,
+                                     uint32_t (*hash_key)(void *, void *),
+                                     int (*compare_keys)(void *, void *,
+                                                         void *),
+                                     void *data);
+
+/* Add a key->value pair to a concurrent hashtable, as
+   add_to_hashtable does. Takes the write lock of one segment.
+
+   O(1) amortized.
+
+   The data pointer is given back to the copy_key, copy_value
+   and hash_key functions as their last argument. These
+   functions may be called by several threads at once.
+*/
+void add_to_concurrent_hashtable(concurrent_hashtable_t *hashtable, void *key,
+                                 void *value,
+                                 void *(*copy_key)(void *, void *),
+                                 void *(*copy_value)(void *, void *),
+                                 uint32_t (*hash_key)(void *, void *),
+                                 void *data);
+
+/* Remove a key from a concurrent hashtable, as
+   remove_from_hashtable does. Takes the write lock of one
+   segment.
+
+   O(1) if no collisions, O(n) if collisions.
+
+   The data pointer is given back to the hash_key, compare_keys,
+   delete_key and delete_value functions as their last
+   argument. These functions may be called by several threads
+   at once.
+*/
+void remove_from_concurrent_hashtable(
+    concurrent_hashtable_t *hashtable, void *key,
+    uint32_t (*hash_key)(void *, void *),
+    int (*compare_keys)(void *, void *, void *),
+    void (*delete_key)(void *, void *), void (*delete_value)(void *, void *),
+    void *data);
+
+/* Resize all segments of a concurrent hashtable so that it can
+   hold the number of entries given in argument, as
+   reserve_hashtable does, one segment at a time.
+
+   O(n)
+*/
+void reserve_concurrent_hashtable(concurrent_hashtable_t *hashtable,
+                                  size_t number_entries);
+
+/* Returns the number of entries in the concurrent hashtable,
+   summed up one segment at a time, so that it need not be
+   exact while other threads add or remove entries.
+
+   O(number of segments)
+*/
+size_t number_entries_in_concurrent_hashtable(
+    concurrent_hashtable_t *hashtable);
+
+/* Returns the maximum number of collisions over all segments
+   of the concurrent hashtable
+
+   O(number of segments)
+*/
+size_t max_number_collisions_in_concurrent_hashtable(
+    concurrent_hashtable_t *hashtable);
+
+#endif
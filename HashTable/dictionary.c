@@ -1,16 +1,78 @@
 #include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
+#include "allocator.h"
+#include "epoch.h"
 #include "hash.h"
 #include "hashtable.h"
+#include "intern.h"
 #include "linkedlists.h"
+#include "mph.h"
+#include "oahashtable.h"
+#include "snapshot.h"
+#include "swisstable.h"
 
-#define HASHTABLE_SIZE (((size_t)1) << 20)
+/* Initial number of buckets, the hashtable grows as needed */
+#define HASHTABLE_SIZE (((size_t)1) << 10)
 #define SPANISH_BUFFER_LEN ((size_t)4096)
 #define LINE_BUFFER_LEN ((size_t)4096)
+/* Number of words looked up at once in batch mode */
+#define BATCH_LOOKUPS ((size_t)1024)
+
+typedef enum {
+  ENGINE_CHAINED,
+  ENGINE_OPEN_ADDRESSING,
+  ENGINE_SWISS,
+  ENGINE_MPH,
+  ENGINE_SNAPSHOT
+} engine_t;
+
+/* When borrowed is set, the keys and meanings point into
+   the private writable mapping of the dictionary file, which
+   has been parsed in place, and are not freed one by one.
+
+   A dictionary opened from a snapshot is queried in the
+   mapped snapshot file and has no hashtable.
+
+   A dictionary of the mph engine is loaded into the chained
+   hashtable, whose entries are then moved to mph_keys and
+   mph_meanings at their index by mph, a minimal perfect hash
+   function over the keys. The hashtable is deleted then.
+
+   When arena is set, the keys, the meaning lists and the
+   chained hashtable are allocated in the arena and released
+   at once with it.
+
+   Meanings that are copied rather than borrowed are interned
+   in pool, which stores each distinct meaning once and is
+   deleted with the dictionary.
+*/
+typedef struct {
+  engine_t engine;
+  hashtable_t *hashtable;
+  oa_hashtable_t *oa_hashtable;
+  swiss_hashtable_t *swiss_hashtable;
+  mph_t *mph;
+  char **mph_keys;
+  list_t **mph_meanings;
+  snapshot_t *snapshot;
+  arena_t *arena;
+  intern_pool_t *pool;
+  int borrowed;
+  char *mapping;
+  size_t mapping_len;
+} dictionary_t;
 
 static void error_no_mem(void) {
   fprintf(stderr, "Error: no memory left.\n");
@@ -42,43 +104,39 @@ static void input_string(char str[], const size_t n) {
   str[i] = '\0';
 }
 
-static void delete_list_entry(void *entry, void *data) {
-  char *pvt_entry = entry;
-
-  free(pvt_entry);
-}
-
 static void delete_key(void *key, void *data) {
   char *pvt_key = key;
 
   free(pvt_key);
 }
 
-static void delete_value(void *value, void *data) {
-  list_t pvt_value = value;
+static void delete_borrowed(void *ptr, void *data) {}
 
-  delete_list(pvt_value, delete_list_entry, NULL);
+static void delete_borrowed_value(void *value, void *data) {
+  list_t *pvt_value = value;
+
+  delete_list(pvt_value, delete_borrowed, NULL);
 }
 
-static void *copy_english_word(void *word, void *data) {
-  char *pvt_word = word;
-  size_t len;
-  char *copied_word;
+static void *borrow_string(void *str, void *data) { return str; }
 
-  len = strlen(pvt_word);
-  copied_word = calloc(len + ((size_t)1), sizeof(*copied_word));
-  if (copied_word == NULL) error_no_mem();
-  strcpy(copied_word, pvt_word);
+/* The data pointer is the pool to intern the word in */
+static void *intern_english_word(void *word, void *data) {
+  intern_pool_t *pvt_data = data;
 
-  return copied_word;
+  return (void *)intern_string(pvt_data, word);
 }
 
-static list_t read_english_meanings(char *english_words) {
-  list_t list;
+/* Interns the meanings in pool, or borrows them if pool is
+   NULL. The list is allocated with allocator.
+*/
+static list_t *read_english_meanings(char *english_words, intern_pool_t *pool,
+                                     allocator_t *allocator) {
+  list_t *list;
   char *head;
   char *tail;
 
-  list = create_list();
+  list = create_list_with_allocator(allocator);
 
   tail = english_words;
   for (;;) {
@@ -92,55 +150,230 @@ static list_t read_english_meanings(char *english_words) {
       tail++;
     }
     if (*head == ' ') head++;
-    append_to_list(list, head, copy_english_word, NULL);
+    append_to_list(list, head,
+                   ((pool == NULL) ? borrow_string : intern_english_word),
+                   pool);
   }
 
   return list;
 }
 
+/* The hashtables call hash_key on an added key right before
+   copy_key. hash_key records the length it found while hashing
+   the key here, so that copy_key does not walk the key again.
+   copy_key copies the key with allocator.
+*/
+typedef struct {
+  const char *key;
+  size_t len;
+  allocator_t *allocator;
+} key_length_t;
+
 static uint32_t hash_key(void *key, void *data) {
   char *pvt_key = key;
+  key_length_t *pvt_data = data;
+  size_t len;
+  uint32_t hash;
 
-  return hash_str(pvt_key);
+  hash = hash_str_len(pvt_key, &len);
+  if (pvt_data != NULL) {
+    pvt_data->key = pvt_key;
+    pvt_data->len = len;
+  }
+
+  return hash;
 }
 
 static void *copy_key(void *key, void *data) {
   char *pvt_key = key;
+  key_length_t *pvt_data = data;
   size_t len;
   char *copied_key;
 
-  len = strlen(pvt_key);
-  copied_key = calloc(len + ((size_t)1), sizeof(*copied_key));
-  if (copied_key == NULL) error_no_mem();
-  strcpy(copied_key, pvt_key);
+  if ((pvt_data != NULL) && (pvt_data->key == pvt_key)) {
+    len = pvt_data->len;
+  } else {
+    len = strlen(pvt_key);
+  }
+  copied_key = allocate_memory(((pvt_data != NULL) ? pvt_data->allocator : NULL),
+                               len + ((size_t)1));
+  memcpy(copied_key, pvt_key, len + ((size_t)1));
 
   return copied_key;
 }
 
 static void *copy_value(void *value, void *data) { return value; }
 
-static int read_dictionary_line(hashtable_t *hashtable, char *line) {
-  char *spanish_word;
+/* Returns the allocator for the keys and meanings of the
+   dictionary, NULL for malloc and free
+*/
+static allocator_t *dictionary_allocator(dictionary_t *dictionary) {
+  if (dictionary->arena == NULL) return NULL;
+
+  return get_arena_allocator(dictionary->arena);
+}
+
+static dictionary_t *create_dictionary(engine_t engine, int use_arena) {
+  dictionary_t *dictionary;
+
+  dictionary = (dictionary_t *)calloc(1, sizeof(dictionary_t));
+  if (dictionary == NULL) error_no_mem();
+
+  dictionary->engine = engine;
+  if (use_arena) dictionary->arena = create_arena((size_t)0);
+  switch (engine) {
+    case ENGINE_OPEN_ADDRESSING:
+      /* Grows on demand, no need to pre-size */
+      dictionary->oa_hashtable = create_oa_hashtable((size_t)0);
+      break;
+    case ENGINE_SWISS:
+      dictionary->swiss_hashtable = create_swiss_hashtable((size_t)0);
+      break;
+    case ENGINE_SNAPSHOT:
+      break;
+    default:
+      dictionary->hashtable = create_hashtable_with_allocator(
+          HASHTABLE_SIZE, dictionary_allocator(dictionary));
+      break;
+  }
+
+  return dictionary;
+}
+
+static void delete_dictionary(dictionary_t *dictionary) {
+  size_t i;
+  void (*delete_key_fn)(void *, void *);
+  void (*delete_value_fn)(void *, void *);
+
+  if (dictionary->arena != NULL) {
+    delete_key_fn = delete_borrowed;
+    delete_value_fn = delete_borrowed;
+  } else if (dictionary->borrowed) {
+    delete_key_fn = delete_borrowed;
+    delete_value_fn = delete_borrowed_value;
+  } else {
+    delete_key_fn = delete_key;
+    delete_value_fn = delete_borrowed_value;
+  }
+  if (dictionary->mph != NULL) {
+    for (i = ((size_t)0); i < number_keys_in_mph(dictionary->mph); i++) {
+      delete_key_fn(dictionary->mph_keys[i], NULL);
+      delete_value_fn(dictionary->mph_meanings[i], NULL);
+    }
+    free(dictionary->mph_keys);
+    free(dictionary->mph_meanings);
+    delete_mph(dictionary->mph);
+  }
+  switch (dictionary->engine) {
+    case ENGINE_OPEN_ADDRESSING:
+      delete_oa_hashtable(dictionary->oa_hashtable, delete_key_fn,
+                          delete_value_fn, NULL);
+      break;
+    case ENGINE_SWISS:
+      delete_swiss_hashtable(dictionary->swiss_hashtable, delete_key_fn,
+                             delete_value_fn, NULL);
+      break;
+    case ENGINE_SNAPSHOT:
+      if (dictionary->snapshot != NULL) close_snapshot(dictionary->snapshot);
+      break;
+    default:
+      /* The arena holds the whole hashtable */
+      if ((dictionary->arena == NULL) && (dictionary->hashtable != NULL)) {
+        delete_hashtable(dictionary->hashtable, delete_key_fn,
+                         delete_value_fn, NULL);
+      }
+      break;
+  }
+  if (dictionary->arena != NULL) delete_arena(dictionary->arena);
+  if (dictionary->pool != NULL) delete_intern_pool(dictionary->pool);
+  if (dictionary->mapping != NULL) {
+    munmap(dictionary->mapping, dictionary->mapping_len);
+  }
+  free(dictionary);
+}
+
+static void add_to_dictionary(dictionary_t *dictionary, char *spanish_word,
+                              list_t *english_meanings) {
+  key_length_t key_length;
+  void *(*copy_key_fn)(void *, void *);
+
+  key_length.key = NULL;
+  key_length.len = (size_t)0;
+  key_length.allocator = dictionary_allocator(dictionary);
+  copy_key_fn = (dictionary->borrowed ? borrow_string : copy_key);
+  switch (dictionary->engine) {
+    case ENGINE_OPEN_ADDRESSING:
+      add_to_oa_hashtable(dictionary->oa_hashtable, spanish_word,
+                          english_meanings, copy_key_fn, copy_value, hash_key,
+                          &key_length);
+      break;
+    case ENGINE_SWISS:
+      add_to_swiss_hashtable(dictionary->swiss_hashtable, spanish_word,
+                             english_meanings, copy_key_fn, copy_value,
+                             hash_key, &key_length);
+      break;
+    default:
+      add_to_hashtable(dictionary->hashtable, spanish_word, english_meanings,
+                       copy_key_fn, copy_value, hash_key, &key_length);
+      break;
+  }
+}
+
+static void reserve_dictionary(dictionary_t *dictionary,
+                               size_t number_entries) {
+  switch (dictionary->engine) {
+    case ENGINE_OPEN_ADDRESSING:
+      reserve_oa_hashtable(dictionary->oa_hashtable, number_entries);
+      break;
+    case ENGINE_SWISS:
+      reserve_swiss_hashtable(dictionary->swiss_hashtable, number_entries);
+      break;
+    default:
+      reserve_hashtable(dictionary->hashtable, number_entries);
+      break;
+  }
+}
+
+/* Splits a line "spanish|english, english, ..." in place into
+   the Spanish word, its length and the list of meanings.
+*/
+static int parse_dictionary_line(char *line, intern_pool_t *pool,
+                                 allocator_t *allocator, char **spanish_word,
+                                 size_t *spanish_len,
+                                 list_t **english_meanings) {
   char *english_words;
-  list_t english_meanings;
 
-  spanish_word = line;
   english_words = strchr(line, '|');
   if (english_words == NULL) return -1;
   *english_words = '\0';
   english_words++;
-  if (strlen(spanish_word) == ((size_t)0)) return -1;
-  if (strlen(english_words) == ((size_t)0)) return -1;
+  if (*line == '\0') return -1;
+  if (*english_words == '\0') return -1;
 
-  english_meanings = read_english_meanings(english_words);
+  *spanish_word = line;
+  *spanish_len = (size_t)(english_words - line) - ((size_t)1);
+  *english_meanings = read_english_meanings(english_words, pool, allocator);
 
-  add_to_hashtable(hashtable, spanish_word, english_meanings, copy_key,
-                   copy_value, hash_key, NULL);
+  return 0;
+}
+
+static int read_dictionary_line(dictionary_t *dictionary, char *line) {
+  char *spanish_word;
+  size_t spanish_len;
+  list_t *english_meanings;
+
+  if (parse_dictionary_line(line, dictionary->pool,
+                            dictionary_allocator(dictionary), &spanish_word,
+                            &spanish_len, &english_meanings) < 0) {
+    return -1;
+  }
+
+  add_to_dictionary(dictionary, spanish_word, english_meanings);
 
   return 0;
 }
 
-static int read_dictionary_file(hashtable_t *hashtable, char *filename) {
+static int read_dictionary_file(dictionary_t *dictionary, char *filename) {
   FILE *file;
   size_t pos;
   char line[LINE_BUFFER_LEN];
@@ -153,13 +386,14 @@ static int read_dictionary_file(hashtable_t *hashtable, char *filename) {
             strerror(errno));
     return -1;
   }
+  dictionary->pool = create_intern_pool();
 
   memset(line, '\0', sizeof(line));
   pos = (size_t)0;
   while ((c = fgetc(file)) != EOF) {
     *((unsigned char *)&ch) = (unsigned char)c;
     if (c == '\n') {
-      if (read_dictionary_line(hashtable, line) < 0) {
+      if (read_dictionary_line(dictionary, line) < 0) {
         fprintf(stderr,
                 "Could not add line \"%s\" from file \"%s\" to dictionary\n",
                 line, filename);
@@ -196,6 +430,277 @@ static int read_dictionary_file(hashtable_t *hashtable, char *filename) {
   return 0;
 }
 
+/* Maps the dictionary file privately and writable into the
+   dictionary, so that it can be parsed in place. The keys and
+   meanings then point into the mapping, which lives as long
+   as the dictionary. Leaves the mapping NULL for an empty file.
+*/
+static int map_dictionary_file(dictionary_t *dictionary, char *filename) {
+  int fd;
+  struct stat st;
+  char *mapping;
+
+  fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Could not open file \"%s\" for reading: %s\n", filename,
+            strerror(errno));
+    return -1;
+  }
+  if (fstat(fd, &st) < 0) {
+    fprintf(stderr, "Could not stat file \"%s\": %s\n", filename,
+            strerror(errno));
+    close(fd);
+    return -1;
+  }
+  if (st.st_size == ((off_t)0)) {
+    close(fd);
+    return 0;
+  }
+
+  mapping = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                 fd, (off_t)0);
+  if (close(fd) != 0) {
+    fprintf(stderr, "Could not close file \"%s\": %s\n", filename,
+            strerror(errno));
+  }
+  if (mapping == MAP_FAILED) {
+    fprintf(stderr, "Could not map file \"%s\": %s\n", filename,
+            strerror(errno));
+    return -1;
+  }
+
+  dictionary->borrowed = 1;
+  dictionary->mapping = mapping;
+  dictionary->mapping_len = (size_t)st.st_size;
+
+  return 0;
+}
+
+/* Loads the dictionary file without copying it, parsing the
+   mapped file in place.
+
+   As with read_dictionary_file, a last line that does not end
+   with a newline is ignored.
+*/
+static int read_dictionary_file_mmap(dictionary_t *dictionary,
+                                     char *filename) {
+  char *line, *end, *newline;
+  size_t number_lines;
+
+  if (map_dictionary_file(dictionary, filename) < 0) return -1;
+  if (dictionary->mapping == NULL) return 0;
+  madvise(dictionary->mapping, dictionary->mapping_len, MADV_SEQUENTIAL);
+  end = dictionary->mapping + dictionary->mapping_len;
+
+  /* Pre-size the hashtable once for all lines */
+  number_lines = (size_t)0;
+  for (line = dictionary->mapping;
+       (newline = memchr(line, '\n', (size_t)(end - line))) != NULL;
+       line = newline + 1) {
+    number_lines++;
+  }
+  reserve_dictionary(dictionary, number_lines);
+
+  for (line = dictionary->mapping;
+       (newline = memchr(line, '\n', (size_t)(end - line))) != NULL;
+       line = newline + 1) {
+    *newline = '\0';
+    if (read_dictionary_line(dictionary, line) < 0) {
+      fprintf(stderr,
+              "Could not add line \"%s\" from file \"%s\" to dictionary\n",
+              line, filename);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/* Lines begin, ..., end - 1 of the mapped dictionary file,
+   parsed and hashed by one worker thread into the arrays
+   keys, lens, meanings and hashes
+*/
+typedef struct {
+  char *begin;
+  char *end;
+  size_t number_entries;
+  size_t capacity;
+  const void **keys;
+  size_t *lens;
+  list_t **meanings;
+  uint32_t *hashes;
+  char *bad_line;
+} shard_t;
+
+static void grow_shard(shard_t *shard) {
+  size_t capacity;
+  void *p;
+
+  capacity = ((shard->capacity == ((size_t)0)) ? ((size_t)1024)
+                                               : (shard->capacity << 1));
+  if ((p = realloc(shard->keys, capacity * sizeof(*(shard->keys)))) == NULL) {
+    error_no_mem();
+  }
+  shard->keys = p;
+  if ((p = realloc(shard->lens, capacity * sizeof(*(shard->lens)))) == NULL) {
+    error_no_mem();
+  }
+  shard->lens = p;
+  if ((p = realloc(shard->meanings, capacity * sizeof(*(shard->meanings)))) ==
+      NULL) {
+    error_no_mem();
+  }
+  shard->meanings = p;
+  shard->capacity = capacity;
+}
+
+static void *parse_shard(void *arg) {
+  shard_t *shard = arg;
+  char *line, *newline, *spanish_word;
+  size_t spanish_len;
+  list_t *english_meanings;
+
+  for (line = shard->begin;
+       (line < shard->end) &&
+       ((newline = memchr(line, '\n', (size_t)(shard->end - line))) != NULL);
+       line = newline + 1) {
+    *newline = '\0';
+    if (parse_dictionary_line(line, NULL, NULL, &spanish_word, &spanish_len,
+                              &english_meanings) < 0) {
+      shard->bad_line = line;
+      return NULL;
+    }
+    if (shard->number_entries >= shard->capacity) grow_shard(shard);
+    shard->keys[shard->number_entries] = spanish_word;
+    shard->lens[shard->number_entries] = spanish_len;
+    shard->meanings[shard->number_entries] = english_meanings;
+    shard->number_entries++;
+  }
+
+  shard->hashes = calloc(shard->number_entries + ((size_t)1),
+                         sizeof(*(shard->hashes)));
+  if (shard->hashes == NULL) error_no_mem();
+  hash_mem_batch(shard->keys, shard->lens, shard->hashes,
+                 shard->number_entries);
+
+  return NULL;
+}
+
+static void add_shard_to_dictionary(dictionary_t *dictionary, shard_t *shard) {
+  size_t i;
+
+  for (i = ((size_t)0); i < shard->number_entries; i++) {
+    switch (dictionary->engine) {
+      case ENGINE_OPEN_ADDRESSING:
+        add_hashed_to_oa_hashtable(dictionary->oa_hashtable,
+                                   (void *)shard->keys[i], shard->meanings[i],
+                                   shard->hashes[i], borrow_string, copy_value,
+                                   NULL);
+        break;
+      case ENGINE_SWISS:
+        add_hashed_to_swiss_hashtable(
+            dictionary->swiss_hashtable, (void *)shard->keys[i],
+            shard->meanings[i], shard->hashes[i], borrow_string, copy_value,
+            NULL);
+        break;
+      default:
+        add_hashed_to_hashtable(dictionary->hashtable, (void *)shard->keys[i],
+                                shard->meanings[i], shard->hashes[i],
+                                borrow_string, copy_value, NULL);
+        break;
+    }
+  }
+}
+
+/* Loads the dictionary file with several threads. The mapped
+   file is split at newline boundaries into one shard per
+   thread. The threads parse their shard in place, build the
+   meaning lists and hash the keys in batches; the entries are
+   then added to the hashtable, pre-sized once, in file order.
+
+   As with read_dictionary_file, a last line that does not end
+   with a newline is ignored.
+*/
+static int read_dictionary_file_parallel(dictionary_t *dictionary,
+                                         char *filename, size_t nthreads) {
+  shard_t *shards;
+  pthread_t *threads;
+  char *begin, *end, *newline;
+  size_t i, number_entries;
+  int res;
+
+  if (map_dictionary_file(dictionary, filename) < 0) return -1;
+  if (dictionary->mapping == NULL) return 0;
+  end = dictionary->mapping + dictionary->mapping_len;
+
+  shards = (shard_t *)calloc(nthreads, sizeof(shard_t));
+  threads = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+  if ((shards == NULL) || (threads == NULL)) error_no_mem();
+
+  begin = dictionary->mapping;
+  for (i = ((size_t)0); i < nthreads; i++) {
+    shards[i].begin = begin;
+    if (i == (nthreads - ((size_t)1))) {
+      shards[i].end = end;
+    } else {
+      shards[i].end = dictionary->mapping +
+                      ((dictionary->mapping_len / nthreads) * (i + ((size_t)1)));
+      if (shards[i].end < begin) shards[i].end = begin;
+      newline = memchr(shards[i].end, '\n', (size_t)(end - shards[i].end));
+      shards[i].end = ((newline == NULL) ? end : (newline + 1));
+    }
+    begin = shards[i].end;
+  }
+
+  for (i = ((size_t)0); i < nthreads; i++) {
+    if (pthread_create(&threads[i], NULL, parse_shard, &shards[i]) != 0) {
+      fprintf(stderr, "Could not create thread: %s\n", strerror(errno));
+      exit(1);
+    }
+  }
+  for (i = ((size_t)0); i < nthreads; i++) pthread_join(threads[i], NULL);
+
+  res = 0;
+  for (i = ((size_t)0); i < nthreads; i++) {
+    if (shards[i].bad_line != NULL) {
+      fprintf(stderr,
+              "Could not add line \"%s\" from file \"%s\" to dictionary\n",
+              shards[i].bad_line, filename);
+      res = -1;
+      break;
+    }
+  }
+
+  if (res == 0) {
+    number_entries = (size_t)0;
+    for (i = ((size_t)0); i < nthreads; i++) {
+      number_entries += shards[i].number_entries;
+    }
+    reserve_dictionary(dictionary, number_entries);
+    for (i = ((size_t)0); i < nthreads; i++) {
+      add_shard_to_dictionary(dictionary, &shards[i]);
+    }
+  } else {
+    for (i = ((size_t)0); i < nthreads; i++) {
+      for (number_entries = ((size_t)0);
+           number_entries < shards[i].number_entries; number_entries++) {
+        delete_borrowed_value(shards[i].meanings[number_entries], NULL);
+      }
+    }
+  }
+
+  for (i = ((size_t)0); i < nthreads; i++) {
+    free(shards[i].keys);
+    free(shards[i].lens);
+    free(shards[i].meanings);
+    free(shards[i].hashes);
+  }
+  free(threads);
+  free(shards);
+
+  return res;
+}
+
 static int compare_keys(void *a, void *b, void *data) {
   char *pvt_a = a;
   char *pvt_b = b;
@@ -209,10 +714,214 @@ static void print_meaning(void *value, void *data) {
   printf("%s\n", pvt_value);
 }
 
-static void lookup_and_display(hashtable_t *hashtable, char *spanish) {
-  list_t value;
+static list_t *lookup_in_mph_index(dictionary_t *dictionary, char *spanish) {
+  size_t len, i;
+
+  len = strlen(spanish);
+  i = lookup_in_mph(dictionary->mph, hash_mem64(spanish, len));
+  if ((i >= number_keys_in_mph(dictionary->mph)) ||
+      (strcmp(dictionary->mph_keys[i], spanish) != 0)) {
+    return NULL;
+  }
+
+  return dictionary->mph_meanings[i];
+}
+
+/* Not for a dictionary opened from a snapshot */
+static list_t *lookup_in_dictionary(dictionary_t *dictionary, char *spanish) {
+  if (dictionary->mph != NULL) return lookup_in_mph_index(dictionary, spanish);
+
+  switch (dictionary->engine) {
+    case ENGINE_OPEN_ADDRESSING:
+      return lookup_in_oa_hashtable(dictionary->oa_hashtable, spanish,
+                                    hash_key, compare_keys, NULL);
+    case ENGINE_SWISS:
+      return lookup_in_swiss_hashtable(dictionary->swiss_hashtable, spanish,
+                                       hash_key, compare_keys, NULL);
+    default:
+      return lookup_in_hashtable(dictionary->hashtable, spanish, hash_key,
+                                 compare_keys, NULL);
+  }
+}
+
+/* Not for a dictionary opened from a snapshot */
+static void lookup_many_in_dictionary(dictionary_t *dictionary, char **spanish,
+                                      size_t n, void **results) {
+  size_t i;
+
+  switch (dictionary->engine) {
+    case ENGINE_CHAINED:
+      lookup_many_in_hashtable(dictionary->hashtable, (void **)spanish, n,
+                               results, hash_key, compare_keys, NULL);
+      break;
+    default:
+      for (i = ((size_t)0); i < n; i++) {
+        results[i] = lookup_in_dictionary(dictionary, spanish[i]);
+      }
+      break;
+  }
+}
+
+static size_t number_entries_in_dictionary(dictionary_t *dictionary) {
+  if (dictionary->mph != NULL) return number_keys_in_mph(dictionary->mph);
+
+  switch (dictionary->engine) {
+    case ENGINE_OPEN_ADDRESSING:
+      return number_entries_in_oa_hashtable(dictionary->oa_hashtable);
+    case ENGINE_SWISS:
+      return number_entries_in_swiss_hashtable(dictionary->swiss_hashtable);
+    case ENGINE_SNAPSHOT:
+      return number_entries_in_snapshot(dictionary->snapshot);
+    default:
+      return number_entries_in_hashtable(dictionary->hashtable);
+  }
+}
+
+static size_t max_number_collisions_in_dictionary(dictionary_t *dictionary) {
+  /* Every key is found in a single probe */
+  if (dictionary->mph != NULL) return 0;
+
+  switch (dictionary->engine) {
+    case ENGINE_OPEN_ADDRESSING:
+      return max_number_collisions_in_oa_hashtable(dictionary->oa_hashtable);
+    case ENGINE_SWISS:
+      return max_number_collisions_in_swiss_hashtable(
+          dictionary->swiss_hashtable);
+    case ENGINE_SNAPSHOT:
+      return max_number_collisions_in_snapshot(dictionary->snapshot);
+    default:
+      return max_number_collisions_in_hashtable(dictionary->hashtable);
+  }
+}
 
-  value = lookup_in_hashtable(hashtable, spanish, hash_key, compare_keys, NULL);
+/* Snapshot values hold the meanings of a word as NUL-terminated
+   strings one after the other
+*/
+typedef struct {
+  snapshot_writer_t *writer;
+  dictionary_t *dictionary;
+  char *buffer;
+  size_t len;
+  size_t capacity;
+} snapshot_saver_t;
+
+static void append_meaning_to_snapshot_value(void *value, void *data) {
+  char *pvt_value = value;
+  snapshot_saver_t *pvt_data = data;
+  size_t len, capacity;
+  char *buffer;
+
+  len = strlen(pvt_value) + ((size_t)1);
+  if ((pvt_data->len + len) > pvt_data->capacity) {
+    capacity = ((pvt_data->capacity == ((size_t)0)) ? ((size_t)256)
+                                                    : pvt_data->capacity);
+    while ((pvt_data->len + len) > capacity) capacity <<= 1;
+    buffer = realloc(pvt_data->buffer, capacity);
+    if (buffer == NULL) error_no_mem();
+    pvt_data->buffer = buffer;
+    pvt_data->capacity = capacity;
+  }
+  memcpy(&(pvt_data->buffer[pvt_data->len]), pvt_value, len);
+  pvt_data->len += len;
+}
+
+static void add_entry_to_snapshot(void *key, void *value, void *data) {
+  char *pvt_key = key;
+  list_t *pvt_value = value;
+  snapshot_saver_t *pvt_data = data;
+
+  /* Of a word added several times, only the entry a lookup
+     finds is saved
+  */
+  if (lookup_in_dictionary(pvt_data->dictionary, pvt_key) != pvt_value) {
+    return;
+  }
+
+  pvt_data->len = (size_t)0;
+  iterate_over_list(pvt_value, append_meaning_to_snapshot_value, pvt_data);
+  add_to_snapshot_writer(pvt_data->writer, pvt_key, strlen(pvt_key),
+                         pvt_data->buffer, pvt_data->len);
+}
+
+static int save_dictionary_snapshot(dictionary_t *dictionary,
+                                    char *filename) {
+  snapshot_saver_t saver;
+  size_t i;
+  int res;
+
+  saver.writer = create_snapshot_writer();
+  saver.dictionary = dictionary;
+  saver.buffer = NULL;
+  saver.len = (size_t)0;
+  saver.capacity = (size_t)0;
+
+  if (dictionary->mph != NULL) {
+    for (i = ((size_t)0); i < number_keys_in_mph(dictionary->mph); i++) {
+      add_entry_to_snapshot(dictionary->mph_keys[i],
+                            dictionary->mph_meanings[i], &saver);
+    }
+  } else {
+    switch (dictionary->engine) {
+      case ENGINE_OPEN_ADDRESSING:
+        iterate_over_oa_hashtable(dictionary->oa_hashtable,
+                                  add_entry_to_snapshot, &saver);
+        break;
+      case ENGINE_SWISS:
+        iterate_over_swiss_hashtable(dictionary->swiss_hashtable,
+                                     add_entry_to_snapshot, &saver);
+        break;
+      default:
+        iterate_over_hashtable(dictionary->hashtable, add_entry_to_snapshot,
+                               &saver);
+        break;
+    }
+  }
+  res = write_snapshot(saver.writer, filename);
+
+  free(saver.buffer);
+  delete_snapshot_writer(saver.writer);
+
+  return res;
+}
+
+static int load_dictionary_snapshot(dictionary_t *dictionary,
+                                    char *filename) {
+  dictionary->snapshot = open_snapshot(filename, 1);
+  if (dictionary->snapshot == NULL) return -1;
+
+  return 0;
+}
+
+static void lookup_and_display_in_snapshot(dictionary_t *dictionary,
+                                           char *spanish) {
+  const char *value;
+  size_t len, i;
+
+  value = lookup_in_snapshot(dictionary->snapshot, spanish, strlen(spanish),
+                             &len);
+  if (value == NULL) {
+    printf("The word \"%s\" has not been found in the dictionary.\n\n",
+           spanish);
+    return;
+  }
+
+  printf("The word \"%s\" has been found with the following meanings:\n",
+         spanish);
+  for (i = ((size_t)0); i < len; i += strlen(&value[i]) + ((size_t)1)) {
+    printf("%s\n", &value[i]);
+  }
+  printf("\n");
+}
+
+static void lookup_and_display(dictionary_t *dictionary, char *spanish) {
+  list_t *value;
+
+  if (dictionary->engine == ENGINE_SNAPSHOT) {
+    lookup_and_display_in_snapshot(dictionary, spanish);
+    return;
+  }
+
+  value = lookup_in_dictionary(dictionary, spanish);
   if (value == NULL) {
     printf("The word \"%s\" has not been found in the dictionary.\n\n",
            spanish);
@@ -225,41 +934,501 @@ static void lookup_and_display(hashtable_t *hashtable, char *spanish) {
   printf("\n");
 }
 
+static void print_batch_meaning(void *value, void *data) {
+  char *pvt_value = value;
+  int *pvt_data = data;
+
+  printf("%s%s", (*pvt_data ? "" : ", "), pvt_value);
+  *pvt_data = 0;
+}
+
+static void print_batch_result(dictionary_t *dictionary, char *spanish,
+                               void *value) {
+  const char *meanings;
+  size_t len, i;
+  int first;
+
+  printf("%s|", spanish);
+  if (dictionary->engine == ENGINE_SNAPSHOT) {
+    meanings = lookup_in_snapshot(dictionary->snapshot, spanish,
+                                  strlen(spanish), &len);
+    for (i = ((size_t)0); (meanings != NULL) && (i < len);
+         i += strlen(&meanings[i]) + ((size_t)1)) {
+      printf("%s%s", ((i == ((size_t)0)) ? "" : ", "), &meanings[i]);
+    }
+  } else if (value != NULL) {
+    first = 1;
+    iterate_over_list(value, print_batch_meaning, &first);
+  }
+  printf("\n");
+}
+
+/* Reads words from standard input, one per line, and looks
+   them up BATCH_LOOKUPS at a time. Prints one line per word
+   in the format of the dictionary file, with no meanings for
+   a word that is not found.
+*/
+static int lookup_batch(dictionary_t *dictionary) {
+  char line[SPANISH_BUFFER_LEN];
+  char *spanish[BATCH_LOOKUPS];
+  void *results[BATCH_LOOKUPS];
+  arena_t *arena;
+  size_t n, len, i;
+  int eof;
+
+  eof = 0;
+  while (!eof) {
+    arena = create_arena((size_t)0);
+    for (n = ((size_t)0); n < BATCH_LOOKUPS; n++) {
+      if (fgets(line, sizeof(line), stdin) == NULL) {
+        eof = 1;
+        break;
+      }
+      len = strlen(line);
+      if ((len > ((size_t)0)) && (line[len - ((size_t)1)] == '\n')) {
+        len--;
+        line[len] = '\0';
+      } else if (!feof(stdin)) {
+        fprintf(stderr,
+                "Could not read a line completely from standard input\n");
+        delete_arena(arena);
+        return -1;
+      }
+      spanish[n] = allocate_in_arena(arena, len + ((size_t)1));
+      memcpy(spanish[n], line, len + ((size_t)1));
+    }
+
+    if (dictionary->engine != ENGINE_SNAPSHOT) {
+      lookup_many_in_dictionary(dictionary, spanish, n, results);
+    }
+    for (i = ((size_t)0); i < n; i++) {
+      print_batch_result(dictionary, spanish[i],
+                         ((dictionary->engine == ENGINE_SNAPSHOT)
+                              ? NULL
+                              : results[i]));
+    }
+    delete_arena(arena);
+  }
+
+  return 0;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "Usage: %s [-e chained|open|swiss|mph] [-m] [-j threads] [-a]\n"
+          "          [--filter <false positive rate>] [--batch]\n"
+          "          [--chain-order fixed|move-to-front|transpose]\n"
+          "          [--save-snapshot <snapshot file>]\n"
+          "          <dictionary file>\n"
+          "       %s [--batch] --load-snapshot <snapshot file>\n"
+          "  -e mph  index the loaded dictionary with a minimal perfect hash\n"
+          "          function instead of a hashtable\n"
+          "  -m  map the file and parse it in place\n"
+          "  -j  parse the file with several threads, implies -m\n"
+          "  -a  allocate the dictionary in an arena, not with -j\n"
+          "  --filter  reject most words missing from the chained hashtable\n"
+          "            with a Bloom filter of the given false positive rate\n"
+          "  --chain-order  reorder the chains of the chained hashtable on\n"
+          "                 each lookup, and report the comparisons made\n"
+          "  --save-snapshot  write the loaded dictionary to a snapshot file\n"
+          "  --load-snapshot  query a snapshot file in place instead of\n"
+          "                   loading a dictionary file\n"
+          "  --batch  look up the words read from standard input, one per\n"
+          "           line, printing \"word|meaning, meaning\" for each\n",
+          name, name);
+  exit(1);
+}
+
+/* Moves the entries of the chained hashtable to the arrays
+   of a minimal perfect hash function built over its keys, and
+   deletes the hashtable. Keeps the hashtable if a key has been
+   added several times, which the function cannot tell apart.
+*/
+typedef struct {
+  char **keys;
+  list_t **meanings;
+  size_t n;
+} mph_collector_t;
+
+static void collect_mph_entry(void *key, void *value, void *data) {
+  mph_collector_t *pvt_data = data;
+
+  pvt_data->keys[pvt_data->n] = key;
+  pvt_data->meanings[pvt_data->n] = value;
+  pvt_data->n++;
+}
+
+static void build_mph_index(dictionary_t *dictionary) {
+  mph_collector_t collector;
+  uint64_t *fingerprints;
+  size_t i, j, n;
+
+  n = number_entries_in_hashtable(dictionary->hashtable);
+  collector.keys = (char **)calloc(n + ((size_t)1), sizeof(char *));
+  collector.meanings = (list_t **)calloc(n + ((size_t)1), sizeof(list_t *));
+  fingerprints = (uint64_t *)calloc(n + ((size_t)1), sizeof(uint64_t));
+  if ((collector.keys == NULL) || (collector.meanings == NULL) ||
+      (fingerprints == NULL)) {
+    error_no_mem();
+  }
+  collector.n = (size_t)0;
+  iterate_over_hashtable(dictionary->hashtable, collect_mph_entry, &collector);
+
+  for (i = ((size_t)0); i < n; i++) {
+    fingerprints[i] =
+        hash_mem64(collector.keys[i], strlen(collector.keys[i]));
+  }
+  dictionary->mph = create_mph(fingerprints, n, MPH_DEFAULT_GAMMA);
+  if (dictionary->mph == NULL) {
+    fprintf(stderr,
+            "Could not build a minimal perfect hash function, some words "
+            "appear several times. The chained hashtable stays in use.\n");
+  } else {
+    dictionary->mph_keys = (char **)calloc(n + ((size_t)1), sizeof(char *));
+    dictionary->mph_meanings =
+        (list_t **)calloc(n + ((size_t)1), sizeof(list_t *));
+    if ((dictionary->mph_keys == NULL) || (dictionary->mph_meanings == NULL)) {
+      error_no_mem();
+    }
+    for (i = ((size_t)0); i < n; i++) {
+      j = lookup_in_mph(dictionary->mph, fingerprints[i]);
+      dictionary->mph_keys[j] = collector.keys[i];
+      dictionary->mph_meanings[j] = collector.meanings[i];
+    }
+    /* The arena holds the whole hashtable */
+    if (dictionary->arena == NULL) {
+      delete_hashtable(dictionary->hashtable, delete_borrowed, delete_borrowed,
+                       NULL);
+    }
+    dictionary->hashtable = NULL;
+  }
+
+  free(fingerprints);
+  free(collector.meanings);
+  free(collector.keys);
+}
+
+/* How a dictionary is loaded, kept for reloading it */
+typedef struct {
+  engine_t engine;
+  int use_mmap;
+  int use_arena;
+  long nthreads;
+  char *filename;
+  double filter_false_positive_rate;
+  int set_chain_order;
+  hashtable_chain_order_t chain_order;
+} load_options_t;
+
+static dictionary_t *load_dictionary(load_options_t *options) {
+  dictionary_t *dictionary;
+  int res;
+
+  dictionary = create_dictionary(options->engine, options->use_arena);
+
+  if (options->engine == ENGINE_SNAPSHOT) {
+    res = load_dictionary_snapshot(dictionary, options->filename);
+  } else if (options->nthreads > 1L) {
+    res = read_dictionary_file_parallel(dictionary, options->filename,
+                                        (size_t)options->nthreads);
+  } else if (options->use_mmap) {
+    res = read_dictionary_file_mmap(dictionary, options->filename);
+  } else {
+    res = read_dictionary_file(dictionary, options->filename);
+  }
+  if (res < 0) {
+    delete_dictionary(dictionary);
+    return NULL;
+  }
+  if (options->engine == ENGINE_MPH) build_mph_index(dictionary);
+  if ((options->engine == ENGINE_CHAINED) &&
+      (options->filter_false_positive_rate > 0.0)) {
+    set_hashtable_filter(dictionary->hashtable,
+                         options->filter_false_positive_rate);
+  }
+  if ((dictionary->hashtable != NULL) && options->set_chain_order) {
+    set_hashtable_chain_order(dictionary->hashtable, options->chain_order);
+    set_hashtable_lookup_counting(dictionary->hashtable, 1);
+  }
+
+  return dictionary;
+}
+
+static double read_seconds(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((double)ts.tv_sec) + ((double)ts.tv_nsec) * 1e-9;
+}
+
+/* The dictionary lookups are served from. Lookups load it
+   inside an epoch of domain. A reload builds a new dictionary
+   in a background thread, swaps it in and deletes the old one
+   once the lookups that may still use it have left their
+   epoch.
+*/
+typedef struct {
+  _Atomic(dictionary_t *) current;
+  epoch_domain_t *domain;
+  load_options_t options;
+  atomic_int reloading;
+  int started;
+  pthread_t thread;
+} served_dictionary_t;
+
+static void delete_retired_dictionary(void *dictionary, void *data) {
+  delete_dictionary(dictionary);
+}
+
+static void *reload_dictionary(void *arg) {
+  served_dictionary_t *served = arg;
+  dictionary_t *dictionary, *old_dictionary;
+  double start, built, swapped, drained;
+
+  start = read_seconds();
+  dictionary = load_dictionary(&(served->options));
+  built = read_seconds();
+  if (dictionary == NULL) {
+    fprintf(stderr,
+            "Could not reload the dictionary from file \"%s\", the current "
+            "dictionary stays in use.\n",
+            served->options.filename);
+    atomic_store(&(served->reloading), 0);
+    return NULL;
+  }
+
+  old_dictionary = atomic_exchange(&(served->current), dictionary);
+  swapped = read_seconds();
+  retire_in_epoch(served->domain, old_dictionary, delete_retired_dictionary,
+                  NULL);
+  synchronize_epoch(served->domain);
+  drained = read_seconds();
+
+  printf(
+      "The dictionary from file \"%s\" has been reloaded with %zu entries.\n"
+      "Build time %.3f s, swap latency %.3f us, old dictionary deleted "
+      "%.3f ms after the swap.\n",
+      served->options.filename, number_entries_in_dictionary(dictionary),
+      built - start, (swapped - built) * 1e6, (drained - swapped) * 1e3);
+  atomic_store(&(served->reloading), 0);
+
+  return NULL;
+}
+
+static void start_reload(served_dictionary_t *served) {
+  if (atomic_exchange(&(served->reloading), 1) != 0) {
+    printf("The dictionary is already being reloaded.\n\n");
+    return;
+  }
+  if (served->started) pthread_join(served->thread, NULL);
+
+  if (pthread_create(&(served->thread), NULL, reload_dictionary, served) !=
+      0) {
+    fprintf(stderr, "Could not create thread: %s\n", strerror(errno));
+    served->started = 0;
+    atomic_store(&(served->reloading), 0);
+    return;
+  }
+  served->started = 1;
+  printf("The dictionary is being reloaded in the background.\n\n");
+}
+
+/* Prints the average number of entries compared by the lookups
+   of the chained hashtable, which --chain-order tries to bring
+   down
+*/
+static void print_lookup_comparisons(dictionary_t *dictionary, FILE *stream) {
+  hashtable_stats_t stats;
+
+  if (dictionary->hashtable == NULL) return;
+
+  get_hashtable_stats(dictionary->hashtable, &stats);
+  fprintf(stream, "%zu lookups compared %.2f entries on average.\n",
+          stats.lookups,
+          ((stats.lookups == ((size_t)0))
+               ? 0.0
+               : ((double)stats.lookup_comparisons) /
+                     ((double)stats.lookups)));
+}
+
+enum {
+  OPT_SAVE_SNAPSHOT = 256,
+  OPT_LOAD_SNAPSHOT,
+  OPT_BATCH,
+  OPT_FILTER,
+  OPT_CHAIN_ORDER
+};
+
+static const struct option long_options[] = {
+    {"save-snapshot", required_argument, NULL, OPT_SAVE_SNAPSHOT},
+    {"load-snapshot", required_argument, NULL, OPT_LOAD_SNAPSHOT},
+    {"batch", no_argument, NULL, OPT_BATCH},
+    {"filter", required_argument, NULL, OPT_FILTER},
+    {"chain-order", required_argument, NULL, OPT_CHAIN_ORDER},
+    {NULL, 0, NULL, 0}};
+
 int main(int argc, char **argv) {
-  hashtable_t *hashtable;
+  dictionary_t *dictionary;
+  served_dictionary_t served;
+  epoch_reader_t *reader;
+  load_options_t *options;
+  hashtable_stats_t stats;
   char spanish[SPANISH_BUFFER_LEN];
+  const char *name;
+  int opt, batch, res;
+  char *endptr, *save_snapshot, *load_snapshot;
 
-  if (argc < 2) {
-    fprintf(stderr, "Usage: %s <dictionary file>\n",
-            ((argc > 0) ? argv[0] : "dictionary"));
-    exit(1);
+  name = ((argc > 0) ? argv[0] : "dictionary");
+  options = &(served.options);
+  options->engine = ENGINE_CHAINED;
+  options->use_mmap = 0;
+  options->use_arena = 0;
+  options->nthreads = 1L;
+  options->filter_false_positive_rate = 0.0;
+  options->set_chain_order = 0;
+  options->chain_order = HASHTABLE_CHAIN_ORDER_FIXED;
+  batch = 0;
+  save_snapshot = NULL;
+  load_snapshot = NULL;
+  while ((opt = getopt_long(argc, argv, "e:mj:a", long_options, NULL)) != -1) {
+    switch (opt) {
+      case 'e':
+        if (strcmp(optarg, "chained") == 0) {
+          options->engine = ENGINE_CHAINED;
+        } else if (strcmp(optarg, "open") == 0) {
+          options->engine = ENGINE_OPEN_ADDRESSING;
+        } else if (strcmp(optarg, "swiss") == 0) {
+          options->engine = ENGINE_SWISS;
+        } else if (strcmp(optarg, "mph") == 0) {
+          options->engine = ENGINE_MPH;
+        } else {
+          usage(name);
+        }
+        break;
+      case 'm':
+        options->use_mmap = 1;
+        break;
+      case 'a':
+        options->use_arena = 1;
+        break;
+      case 'j':
+        options->nthreads = strtol(optarg, &endptr, 10);
+        if ((*endptr != '\0') || (options->nthreads < 1L) ||
+            (options->nthreads > 1024L)) {
+          usage(name);
+        }
+        break;
+      case OPT_SAVE_SNAPSHOT:
+        save_snapshot = optarg;
+        break;
+      case OPT_LOAD_SNAPSHOT:
+        load_snapshot = optarg;
+        break;
+      case OPT_BATCH:
+        batch = 1;
+        break;
+      case OPT_FILTER:
+        options->filter_false_positive_rate = strtod(optarg, &endptr);
+        if ((*endptr != '\0') ||
+            !((options->filter_false_positive_rate > 0.0) &&
+              (options->filter_false_positive_rate < 1.0))) {
+          usage(name);
+        }
+        break;
+      case OPT_CHAIN_ORDER:
+        if (strcmp(optarg, "fixed") == 0) {
+          options->chain_order = HASHTABLE_CHAIN_ORDER_FIXED;
+        } else if (strcmp(optarg, "move-to-front") == 0) {
+          options->chain_order = HASHTABLE_CHAIN_ORDER_MOVE_TO_FRONT;
+        } else if (strcmp(optarg, "transpose") == 0) {
+          options->chain_order = HASHTABLE_CHAIN_ORDER_TRANSPOSE;
+        } else {
+          usage(name);
+        }
+        options->set_chain_order = 1;
+        break;
+      default:
+        usage(name);
+    }
+  }
+  /* The threads of -j allocate with malloc */
+  if (options->use_arena && (options->nthreads > 1L)) usage(name);
+  if ((options->filter_false_positive_rate > 0.0) &&
+      ((options->engine != ENGINE_CHAINED) || (load_snapshot != NULL))) {
+    usage(name);
+  }
+  if (options->set_chain_order &&
+      ((options->engine != ENGINE_CHAINED) || (load_snapshot != NULL))) {
+    usage(name);
+  }
+  if (load_snapshot != NULL) {
+    if ((optind < argc) || (save_snapshot != NULL) || options->use_arena) {
+      usage(name);
+    }
+    options->engine = ENGINE_SNAPSHOT;
+    options->filename = load_snapshot;
+  } else {
+    if (optind >= argc) usage(name);
+    options->filename = argv[optind];
   }
 
-  hashtable = create_hashtable(HASHTABLE_SIZE);
+  dictionary = load_dictionary(options);
+  if (dictionary == NULL) return 1;
+  if (save_snapshot != NULL) {
+    if (save_dictionary_snapshot(dictionary, save_snapshot) < 0) {
+      delete_dictionary(dictionary);
+      return 1;
+    }
+  }
 
-  if (read_dictionary_file(hashtable, argv[1]) < 0) {
-    delete_hashtable(hashtable, delete_key, delete_value, NULL);
-    return 1;
+  if (batch) {
+    res = lookup_batch(dictionary);
+    if (options->set_chain_order) print_lookup_comparisons(dictionary, stderr);
+    delete_dictionary(dictionary);
+    return ((res < 0) ? 1 : 0);
   }
 
   printf(
       "The dictionary from file \"%s\" has been loaded into the hashtable.\n",
-      argv[1]);
+      options->filename);
   printf("The hashtable has %zu entries. There are maximally %zu collisions.\n",
-         number_entries_in_hashtable(hashtable),
-         max_number_collisions_in_hashtable(hashtable));
+         number_entries_in_dictionary(dictionary),
+         max_number_collisions_in_dictionary(dictionary));
+
+  atomic_init(&(served.current), dictionary);
+  atomic_init(&(served.reloading), 0);
+  served.domain = create_epoch_domain();
+  served.started = 0;
+  reader = register_epoch_reader(served.domain);
 
   for (;;) {
     memset(spanish, '\0', sizeof(spanish));
     printf(
-        "Enter a Spanish word to look up. Enter <quit> (with the < > signs) to "
-        "quit.\n");
+        "Enter a Spanish word to look up. Enter <reload> to reload the "
+        "dictionary file, <quit> (with the < > signs) to quit.\n");
     input_string(spanish, sizeof(spanish));
     if (strcmp(spanish, "<quit>") == 0) break;
-    lookup_and_display(hashtable, spanish);
+    if (strcmp(spanish, "<reload>") == 0) {
+      start_reload(&served);
+      continue;
+    }
+    enter_epoch(reader);
+    lookup_and_display(atomic_load(&(served.current)), spanish);
+    exit_epoch(reader);
   }
 
-  delete_hashtable(hashtable, delete_key, delete_value, NULL);
+  if (served.started) pthread_join(served.thread, NULL);
+  unregister_epoch_reader(served.domain, reader);
+  delete_epoch_domain(served.domain);
+  dictionary = atomic_load(&(served.current));
+  if ((dictionary->hashtable != NULL) &&
+      (dictionary->hashtable->filter != NULL)) {
+    get_hashtable_stats(dictionary->hashtable, &stats);
+    printf("The filter rejected %zu of %zu lookups.\n",
+           stats.filter_rejections, stats.filter_lookups);
+  }
+  if (options->set_chain_order) print_lookup_comparisons(dictionary, stdout);
+  delete_dictionary(dictionary);
 
   return 0;
 }
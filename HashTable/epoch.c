@@ -0,0 +1,200 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "epoch.h"
+
+/* active is the epoch the reader has entered, or 0 if it is
+   outside of any epoch. The global epoch starts at 1.
+*/
+struct __epoch_reader_struct_t {
+  _Atomic uint64_t active;
+  epoch_domain_t *domain;
+  struct __epoch_reader_struct_t *next;
+};
+
+typedef struct __epoch_retired_struct_t {
+  void *ptr;
+  void (*delete_ptr)(void *, void *);
+  void *data;
+  uint64_t epoch;
+  struct __epoch_retired_struct_t *next;
+} __epoch_retired_t;
+
+/* The retired list is kept newest first */
+struct __epoch_domain_struct_t {
+  _Atomic uint64_t epoch;
+  pthread_mutex_t lock;
+  epoch_reader_t *readers;
+  __epoch_retired_t *retired;
+};
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+epoch_domain_t *create_epoch_domain(void) {
+  epoch_domain_t *domain;
+
+  domain = (epoch_domain_t *)calloc(1, sizeof(epoch_domain_t));
+  if (domain == NULL) error_no_mem();
+
+  atomic_init(&(domain->epoch), (uint64_t)1);
+  if (pthread_mutex_init(&(domain->lock), NULL) != 0) error_no_mem();
+  domain->readers = NULL;
+  domain->retired = NULL;
+
+  return domain;
+}
+
+static void __delete_retired(__epoch_retired_t *retired) {
+  __epoch_retired_t *curr, *next;
+
+  for (curr = retired; curr != NULL; curr = next) {
+    next = curr->next;
+    curr->delete_ptr(curr->ptr, curr->data);
+    free(curr);
+  }
+}
+
+void delete_epoch_domain(epoch_domain_t *domain) {
+  epoch_reader_t *curr, *next;
+
+  __delete_retired(domain->retired);
+  for (curr = domain->readers; curr != NULL; curr = next) {
+    next = curr->next;
+    free(curr);
+  }
+  pthread_mutex_destroy(&(domain->lock));
+  free(domain);
+}
+
+epoch_reader_t *register_epoch_reader(epoch_domain_t *domain) {
+  epoch_reader_t *reader;
+
+  reader = (epoch_reader_t *)calloc(1, sizeof(epoch_reader_t));
+  if (reader == NULL) error_no_mem();
+
+  atomic_init(&(reader->active), (uint64_t)0);
+  reader->domain = domain;
+
+  pthread_mutex_lock(&(domain->lock));
+  reader->next = domain->readers;
+  domain->readers = reader;
+  pthread_mutex_unlock(&(domain->lock));
+
+  return reader;
+}
+
+void unregister_epoch_reader(epoch_domain_t *domain, epoch_reader_t *reader) {
+  epoch_reader_t **curr;
+
+  pthread_mutex_lock(&(domain->lock));
+  for (curr = &(domain->readers); *curr != NULL; curr = &((*curr)->next)) {
+    if (*curr == reader) {
+      *curr = reader->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&(domain->lock));
+
+  free(reader);
+}
+
+/* The fence orders the store of the entered epoch before all
+   loads of the shared structure. A writer fences between
+   unlinking memory and looking at the readers, so either the
+   writer sees the reader inside its epoch, or the reader does
+   not see the unlinked memory.
+*/
+void enter_epoch(epoch_reader_t *reader) {
+  atomic_store_explicit(
+      &(reader->active),
+      atomic_load_explicit(&(reader->domain->epoch), memory_order_relaxed),
+      memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+}
+
+void exit_epoch(epoch_reader_t *reader) {
+  atomic_store_explicit(&(reader->active), (uint64_t)0, memory_order_release);
+}
+
+void retire_in_epoch(epoch_domain_t *domain, void *ptr,
+                     void (*delete_ptr)(void *, void *), void *data) {
+  __epoch_retired_t *retired;
+
+  retired = (__epoch_retired_t *)calloc(1, sizeof(__epoch_retired_t));
+  if (retired == NULL) error_no_mem();
+
+  retired->ptr = ptr;
+  retired->delete_ptr = delete_ptr;
+  retired->data = data;
+
+  pthread_mutex_lock(&(domain->lock));
+  retired->epoch =
+      atomic_load_explicit(&(domain->epoch), memory_order_relaxed);
+  retired->next = domain->retired;
+  domain->retired = retired;
+  pthread_mutex_unlock(&(domain->lock));
+}
+
+/* Memory retired in epoch e may still be in use by readers that
+   entered epoch e, or e - 1, before it has been unlinked. Once
+   the global epoch is e + 2, all those readers have left.
+*/
+size_t reclaim_epoch(epoch_domain_t *domain) {
+  epoch_reader_t *reader;
+  __epoch_retired_t **curr, *freed, *next;
+  uint64_t epoch, active;
+  size_t n;
+
+  atomic_thread_fence(memory_order_seq_cst);
+
+  pthread_mutex_lock(&(domain->lock));
+  epoch = atomic_load_explicit(&(domain->epoch), memory_order_relaxed);
+  for (reader = domain->readers; reader != NULL; reader = reader->next) {
+    active = atomic_load_explicit(&(reader->active), memory_order_acquire);
+    if ((active != ((uint64_t)0)) && (active != epoch)) break;
+  }
+  if (reader == NULL) {
+    epoch++;
+    atomic_store_explicit(&(domain->epoch), epoch, memory_order_release);
+  }
+
+  /* The list is newest first, so everything past the first
+     old enough entry is old enough too
+  */
+  for (curr = &(domain->retired); *curr != NULL; curr = &((*curr)->next)) {
+    if (((*curr)->epoch + ((uint64_t)2)) <= epoch) break;
+  }
+  freed = *curr;
+  *curr = NULL;
+  pthread_mutex_unlock(&(domain->lock));
+
+  n = (size_t)0;
+  for (; freed != NULL; freed = next) {
+    next = freed->next;
+    freed->delete_ptr(freed->ptr, freed->data);
+    free(freed);
+    n++;
+  }
+
+  return n;
+}
+
+void synchronize_epoch(epoch_domain_t *domain) {
+  for (;;) {
+    reclaim_epoch(domain);
+    pthread_mutex_lock(&(domain->lock));
+    if (domain->retired == NULL) {
+      pthread_mutex_unlock(&(domain->lock));
+      return;
+    }
+    pthread_mutex_unlock(&(domain->lock));
+    sched_yield();
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef __EPOCH_H__
+#define __EPOCH_H__
+
+#include <stdlib.h>
+
+/* Epoch-based reclamation of memory that readers may still be
+   using after it has been unlinked from a shared structure.
+
+   A reader brackets every access to the structure with
+   enter_epoch and exit_epoch. These only write the reader's own
+   record and take no lock. A writer unlinks memory, then hands
+   it to retire_in_epoch instead of freeing it. Retired memory
+   is deleted once every reader that might have seen it has left
+   its epoch, which takes two advances of the global epoch.
+*/
+typedef struct __epoch_domain_struct_t epoch_domain_t;
+typedef struct __epoch_reader_struct_t epoch_reader_t;
+
+/* Create an epoch domain with no readers and nothing retired
+
+   O(1)
+*/
+epoch_domain_t *create_epoch_domain(void);
+
+/* Delete an epoch domain. Deletes all retired memory at once.
+   No reader may be registered any longer.
+
+   O(n)
+*/
+void delete_epoch_domain(epoch_domain_t *domain);
+
+/* Register a reader with an epoch domain. Each reading thread
+   needs a reader of its own.
+
+   O(1)
+*/
+epoch_reader_t *register_epoch_reader(epoch_domain_t *domain);
+
+/* Unregister a reader, which must not be inside an epoch
+
+   O(number of readers)
+*/
+void unregister_epoch_reader(epoch_domain_t *domain, epoch_reader_t *reader);
+
+/* Enter the current epoch. Memory reached from now on is not
+   deleted before exit_epoch.
+
+   O(1)
+*/
+void enter_epoch(epoch_reader_t *reader);
+
+/* Leave the epoch entered with enter_epoch
+
+   O(1)
+*/
+void exit_epoch(epoch_reader_t *reader);
+
+/* Hand memory that is no longer reachable by new readers to the
+   domain. Calls delete_ptr on ptr, with data as its last
+   argument, once no reader can still be using it.
+
+   O(1)
+*/
+void retire_in_epoch(epoch_domain_t *domain, void *ptr,
+                     void (*delete_ptr)(void *, void *), void *data);
+
+/* Advance the global epoch if all readers inside an epoch have
+   seen the current one, and delete the retired memory no
+   reader can still be using. Never waits. Returns the number
+   of pointers deleted.
+
+   O(number of readers + number of retired pointers)
+*/
+size_t reclaim_epoch(epoch_domain_t *domain);
+
+/* Wait until all memory retired so far has been deleted, i.e.
+   until every reader inside an epoch has left it.
+
+   Must not be called from inside an epoch.
+*/
+void synchronize_epoch(epoch_domain_t *domain);
+
+#endif
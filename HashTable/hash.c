@@ -1,6 +1,12 @@
+#include <stdatomic.h>
 #include <stdint.h>
 #include <string.h>
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define HASH_HAVE_X86_SIMD
+#endif
+
 #include "hash.h"
 
 /* 2^64 - 257 is prime */
@@ -12,6 +18,35 @@
 /* prime */
 #define B ((uint64_t)(14721169578037290713ull))
 
+/* Odd constants of the fast family: the 64-bit golden ratio
+   and the multipliers of the splitmix64 finalizer
+*/
+#define FAST_P1 ((uint64_t)(0x9e3779b97f4a7c15ull))
+#define FAST_P2 ((uint64_t)(0xbf58476d1ce4e5b9ull))
+#define FAST_P3 ((uint64_t)(0x94d049bb133111ebull))
+#define FAST_SEED ((uint64_t)(0x2d358dccaa6c78a5ull))
+
+/* Words are never read across such a boundary */
+#define PAGE_SIZE_MIN ((uintptr_t)4096)
+
+/* The word loads of load_str_word may read past the NUL, within
+   the same page, which AddressSanitizer would report
+*/
+#if defined(__SANITIZE_ADDRESS__)
+#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#define NO_SANITIZE_ADDRESS
+#endif
+
+#define ONES ((uint64_t)(0x0101010101010101ull))
+#define HIGHS ((uint64_t)(0x8080808080808080ull))
+
+static hash_family_t hash_family = HASH_FAMILY_FAST;
+
+void set_hash_family(hash_family_t family) { hash_family = family; }
+
+hash_family_t get_hash_family(void) { return hash_family; }
+
 static inline uint64_t add_uint64_mod_q(uint64_t a, uint64_t b) {
   __uint128_t t;
   uint64_t c, s;
@@ -35,7 +70,7 @@ static inline uint64_t mul_uint64_mod_q(uint64_t a, uint64_t b) {
   return (((s % Q) + (c * TWO64_MOD_Q)) % Q);
 }
 
-uint32_t hash_uint64(uint64_t a) {
+static inline uint32_t strong_hash_uint64(uint64_t a) {
   uint64_t prod, sum;
 
   prod = mul_uint64_mod_q(a, A);
@@ -44,6 +79,51 @@ uint32_t hash_uint64(uint64_t a) {
   return (uint32_t)sum;
 }
 
+/* Avalanche step: every input bit affects every output bit */
+static inline uint64_t fast_fmix64(uint64_t x) {
+  x ^= x >> 30;
+  x *= FAST_P2;
+  x ^= x >> 27;
+  x *= FAST_P3;
+  x ^= x >> 31;
+
+  return x;
+}
+
+/* Absorbs one 8-byte word into the running state */
+static inline uint64_t fast_absorb(uint64_t h, uint64_t w) {
+  h = (h ^ w) * FAST_P1;
+
+  return h ^ (h >> 32);
+}
+
+/* Returns the 1 to 7 bytes at p as a zero-padded word, the
+   same as a memcpy into a zeroed word, without calling memcpy
+   with a variable length
+*/
+static inline uint64_t fast_load_tail(const unsigned char *p, size_t r) {
+  uint32_t lo, hi;
+
+  if (r >= ((size_t)4)) {
+    memcpy(&lo, p, sizeof(lo));
+    memcpy(&hi, p + r - ((size_t)4), sizeof(hi));
+    return ((uint64_t)lo) | (((uint64_t)hi) << ((r - ((size_t)4)) << 3));
+  }
+
+  return ((uint64_t)p[0]) | (((uint64_t)p[r >> 1]) << ((r >> 1) << 3)) |
+         (((uint64_t)p[r - ((size_t)1)]) << ((r - ((size_t)1)) << 3));
+}
+
+static inline uint32_t fast_hash_uint64(uint64_t a) {
+  return (uint32_t)fast_fmix64(a + FAST_P1);
+}
+
+uint32_t hash_uint64(uint64_t a) {
+  if (hash_family == HASH_FAMILY_STRONG) return strong_hash_uint64(a);
+
+  return fast_hash_uint64(a);
+}
+
 uint32_t hash_int64(int64_t a) {
   int64_t aa;
 
@@ -86,7 +166,7 @@ static inline uint32_t hash_mem_up_to_8(const void *ptr, const size_t n) {
     memcpy(&t, ptr, n);
   }
 
-  return hash_uint64(t);
+  return strong_hash_uint64(t);
 }
 
 static inline uint32_t hash_combine(uint32_t a, uint32_t b) {
@@ -97,31 +177,364 @@ static inline uint32_t hash_combine(uint32_t a, uint32_t b) {
   l = (uint64_t)b;
   t = h | l;
 
-  return hash_uint64(t);
+  return strong_hash_uint64(t);
 }
 
-uint32_t hash_mem(const void *ptr, size_t n) {
+static uint32_t strong_hash_mem(const void *ptr, size_t n) {
   size_t w, r, i;
   uint32_t t, tt;
 
   if (n <= ((size_t)8)) return hash_mem_up_to_8(ptr, n);
 
   w = n >> 3;
-  r = n - (n << 3);
+  r = n - (w << 3);
 
   t = hash_mem_up_to_8(ptr, ((size_t)8));
   w--;
   for (i = ((size_t)0); i < w; i++) {
-    tt =
-        hash_mem_up_to_8(&(((char *)ptr)[(i + ((size_t)1)) << 3]), ((size_t)8));
+    tt = hash_mem_up_to_8(&(((const char *)ptr)[(i + ((size_t)1)) << 3]),
+                          ((size_t)8));
     t = hash_combine(t, tt);
   }
   if (r > ((size_t)0)) {
-    tt = hash_mem_up_to_8(&(((char *)ptr)[(i + ((size_t)1)) << 3]), r);
+    tt = hash_mem_up_to_8(&(((const char *)ptr)[(i + ((size_t)1)) << 3]), r);
     t = hash_combine(t, tt);
   }
 
   return t;
 }
 
-uint32_t hash_str(const char *ptr) { return hash_mem(ptr, strlen(ptr)); }
+/* Returns the state of the fast family after absorbing a memory
+   area and its length, before the avalanche step
+*/
+static inline uint64_t fast_absorb_mem(const void *ptr, size_t n) {
+  const unsigned char *p = ptr;
+  size_t r;
+  uint64_t h, t;
+
+  h = FAST_SEED;
+  for (r = n; r >= ((size_t)8); r -= ((size_t)8), p += 8) {
+    memcpy(&t, p, sizeof(t));
+    h = fast_absorb(h, t);
+  }
+  if (r > ((size_t)0)) {
+    h = fast_absorb(h, fast_load_tail(p, r));
+  }
+
+  return h ^ ((uint64_t)n);
+}
+
+static uint32_t fast_hash_mem(const void *ptr, size_t n) {
+  return (uint32_t)fast_fmix64(fast_absorb_mem(ptr, n));
+}
+
+uint32_t hash_mem(const void *ptr, size_t n) {
+  if (hash_family == HASH_FAMILY_STRONG) return strong_hash_mem(ptr, n);
+
+  return fast_hash_mem(ptr, n);
+}
+
+uint64_t hash_mem64(const void *ptr, size_t n) {
+  if (hash_family == HASH_FAMILY_STRONG) {
+    return (((uint64_t)fast_hash_mem(ptr, n)) << 32) |
+           ((uint64_t)strong_hash_mem(ptr, n));
+  }
+
+  return fast_fmix64(fast_absorb_mem(ptr, n));
+}
+
+/* Loads the next word of a NUL-terminated string into w,
+   zero-padded past the NUL. Returns the number of bytes
+   before the NUL, or 8 if the word does not contain it.
+*/
+NO_SANITIZE_ADDRESS static inline size_t load_str_word(const unsigned char *p,
+                                                      uint64_t *w) {
+  uint64_t t, z;
+  size_t r;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  if ((((uintptr_t)p) & (PAGE_SIZE_MIN - ((uintptr_t)1))) <=
+      (PAGE_SIZE_MIN - ((uintptr_t)8))) {
+    memcpy(&t, p, sizeof(t));
+    /* Lowest set bit marks the first zero byte */
+    z = (t - ONES) & ~t & HIGHS;
+    if (z == ((uint64_t)0)) {
+      *w = t;
+      return (size_t)8;
+    }
+    r = ((size_t)__builtin_ctzll(z)) >> 3;
+    *w = t & ((((uint64_t)1) << (r << 3)) - ((uint64_t)1));
+    return r;
+  }
+#endif
+
+  t = (uint64_t)0;
+  for (r = ((size_t)0); (r < ((size_t)8)) && (p[r] != '\0'); r++);
+  if (r > ((size_t)0)) memcpy(&t, p, r);
+  *w = t;
+
+  return r;
+}
+
+static uint32_t strong_hash_str_len(const char *ptr, size_t *len) {
+  const unsigned char *p = (const unsigned char *)ptr;
+  size_t n, r;
+  uint64_t w;
+  uint32_t t;
+
+  r = load_str_word(p, &w);
+  n = r;
+  t = strong_hash_uint64(w);
+  while (r == ((size_t)8)) {
+    p += 8;
+    r = load_str_word(p, &w);
+    n += r;
+    if (r > ((size_t)0)) t = hash_combine(t, strong_hash_uint64(w));
+  }
+
+  if (len != NULL) *len = n;
+
+  return t;
+}
+
+static uint32_t fast_hash_str_len(const char *ptr, size_t *len) {
+  const unsigned char *p = (const unsigned char *)ptr;
+  size_t n, r;
+  uint64_t h, w;
+
+  h = FAST_SEED;
+  n = (size_t)0;
+  do {
+    r = load_str_word(p, &w);
+    if (r > ((size_t)0)) h = fast_absorb(h, w);
+    n += r;
+    p += 8;
+  } while (r == ((size_t)8));
+
+  if (len != NULL) *len = n;
+
+  return (uint32_t)fast_fmix64(h ^ ((uint64_t)n));
+}
+
+uint32_t hash_str_len(const char *ptr, size_t *len) {
+  if (hash_family == HASH_FAMILY_STRONG) return strong_hash_str_len(ptr, len);
+
+  return fast_hash_str_len(ptr, len);
+}
+
+uint32_t hash_str(const char *ptr) { return hash_str_len(ptr, NULL); }
+
+/* The batch functions run the avalanche step of the fast family
+   on several lanes at once. SSE4.2 and AVX2 only multiply 32-bit
+   halves, so a 64-bit product keeps its low half only, which is
+   all the fast family needs:
+   lo(a * b) = lo(a) * lo(b) + ((hi(a) * lo(b) + lo(a) * hi(b)) << 32).
+
+   In hash_mem_batch, the words of each area are absorbed with
+   scalar code, which overlaps well across independent keys:
+   gathering words of unequal-length keys into lanes costs more
+   than the single multiply they need. The avalanche step, two
+   multiplies per key, runs on the lanes.
+*/
+#ifdef HASH_HAVE_X86_SIMD
+
+__attribute__((target("avx2"))) static inline __m256i avx2_mullo64(__m256i a,
+                                                                   uint64_t b) {
+  __m256i bb, lo, cross;
+
+  bb = _mm256_set1_epi64x((long long)b);
+  lo = _mm256_mul_epu32(a, bb);
+  cross = _mm256_add_epi64(
+      _mm256_mul_epu32(_mm256_srli_epi64(a, 32), bb),
+      _mm256_mul_epu32(a, _mm256_set1_epi64x((long long)(b >> 32))));
+
+  return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx2"))) static inline __m256i avx2_fmix64(__m256i x) {
+  x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 30));
+  x = avx2_mullo64(x, FAST_P2);
+  x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 27));
+  x = avx2_mullo64(x, FAST_P3);
+  x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 31));
+
+  return x;
+}
+
+/* Stores the low 32 bits of the 4 lanes */
+__attribute__((target("avx2"))) static inline void avx2_store_hashes(
+    uint32_t *hashes, __m256i x) {
+  uint64_t t[4];
+  size_t j;
+
+  _mm256_storeu_si256((__m256i *)t, x);
+  for (j = ((size_t)0); j < ((size_t)4); j++) hashes[j] = (uint32_t)t[j];
+}
+
+__attribute__((target("avx2"))) static size_t avx2_hash_uint64_batch(
+    const uint64_t *keys, uint32_t *hashes, size_t n) {
+  size_t i;
+  __m256i x;
+
+  for (i = ((size_t)0); (i + ((size_t)4)) <= n; i += ((size_t)4)) {
+    x = _mm256_loadu_si256((const __m256i *)&keys[i]);
+    x = _mm256_add_epi64(x, _mm256_set1_epi64x((long long)FAST_P1));
+    avx2_store_hashes(&hashes[i], avx2_fmix64(x));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t avx2_hash_mem_batch(
+    const void *const *ptrs, const size_t *lens, uint32_t *hashes, size_t n) {
+  size_t i;
+  __m256i h;
+
+  for (i = ((size_t)0); (i + ((size_t)4)) <= n; i += ((size_t)4)) {
+    h = _mm256_set_epi64x(
+        (long long)fast_absorb_mem(ptrs[i + ((size_t)3)],
+                                   lens[i + ((size_t)3)]),
+        (long long)fast_absorb_mem(ptrs[i + ((size_t)2)],
+                                   lens[i + ((size_t)2)]),
+        (long long)fast_absorb_mem(ptrs[i + ((size_t)1)],
+                                   lens[i + ((size_t)1)]),
+        (long long)fast_absorb_mem(ptrs[i], lens[i]));
+    avx2_store_hashes(&hashes[i], avx2_fmix64(h));
+  }
+
+  return i;
+}
+
+__attribute__((target("sse4.2"))) static inline __m128i sse_mullo64(__m128i a,
+                                                                    uint64_t b) {
+  __m128i bb, lo, cross;
+
+  bb = _mm_set1_epi64x((long long)b);
+  lo = _mm_mul_epu32(a, bb);
+  cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), bb),
+                        _mm_mul_epu32(a, _mm_set1_epi64x((long long)(b >> 32))));
+
+  return _mm_add_epi64(lo, _mm_slli_epi64(cross, 32));
+}
+
+__attribute__((target("sse4.2"))) static inline __m128i sse_fmix64(__m128i x) {
+  x = _mm_xor_si128(x, _mm_srli_epi64(x, 30));
+  x = sse_mullo64(x, FAST_P2);
+  x = _mm_xor_si128(x, _mm_srli_epi64(x, 27));
+  x = sse_mullo64(x, FAST_P3);
+  x = _mm_xor_si128(x, _mm_srli_epi64(x, 31));
+
+  return x;
+}
+
+__attribute__((target("sse4.2"))) static inline void sse_store_hashes(
+    uint32_t *hashes, __m128i x) {
+  uint64_t t[2];
+
+  _mm_storeu_si128((__m128i *)t, x);
+  hashes[0] = (uint32_t)t[0];
+  hashes[1] = (uint32_t)t[1];
+}
+
+__attribute__((target("sse4.2"))) static size_t sse_hash_uint64_batch(
+    const uint64_t *keys, uint32_t *hashes, size_t n) {
+  size_t i;
+  __m128i x;
+
+  for (i = ((size_t)0); (i + ((size_t)2)) <= n; i += ((size_t)2)) {
+    x = _mm_loadu_si128((const __m128i *)&keys[i]);
+    x = _mm_add_epi64(x, _mm_set1_epi64x((long long)FAST_P1));
+    sse_store_hashes(&hashes[i], sse_fmix64(x));
+  }
+
+  return i;
+}
+
+__attribute__((target("sse4.2"))) static size_t sse_hash_mem_batch(
+    const void *const *ptrs, const size_t *lens, uint32_t *hashes, size_t n) {
+  size_t i;
+  __m128i h;
+
+  for (i = ((size_t)0); (i + ((size_t)2)) <= n; i += ((size_t)2)) {
+    h = _mm_set_epi64x((long long)fast_absorb_mem(ptrs[i + ((size_t)1)],
+                                                  lens[i + ((size_t)1)]),
+                       (long long)fast_absorb_mem(ptrs[i], lens[i]));
+    sse_store_hashes(&hashes[i], sse_fmix64(h));
+  }
+
+  return i;
+}
+
+typedef enum { SIMD_NONE, SIMD_SSE42, SIMD_AVX2, SIMD_UNKNOWN } simd_level_t;
+
+/* Resolved on first use, possibly by several threads hashing
+   at the same time: they all find and store the same level
+*/
+static _Atomic int simd_level = SIMD_UNKNOWN;
+
+static simd_level_t get_simd_level(void) {
+  simd_level_t level;
+
+  level = (simd_level_t)atomic_load_explicit(&simd_level,
+                                             memory_order_relaxed);
+  if (level == SIMD_UNKNOWN) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      level = SIMD_AVX2;
+    } else if (__builtin_cpu_supports("sse4.2")) {
+      level = SIMD_SSE42;
+    } else {
+      level = SIMD_NONE;
+    }
+    atomic_store_explicit(&simd_level, (int)level, memory_order_relaxed);
+  }
+
+  return level;
+}
+
+#endif
+
+void hash_uint64_batch(const uint64_t *keys, uint32_t *hashes, size_t n) {
+  size_t i;
+
+  i = (size_t)0;
+#ifdef HASH_HAVE_X86_SIMD
+  if (hash_family == HASH_FAMILY_FAST) {
+    switch (get_simd_level()) {
+      case SIMD_AVX2:
+        i = avx2_hash_uint64_batch(keys, hashes, n);
+        break;
+      case SIMD_SSE42:
+        i = sse_hash_uint64_batch(keys, hashes, n);
+        break;
+      default:
+        break;
+    }
+  }
+#endif
+
+  for (; i < n; i++) hashes[i] = hash_uint64(keys[i]);
+}
+
+void hash_mem_batch(const void *const *ptrs, const size_t *lens,
+                    uint32_t *hashes, size_t n) {
+  size_t i;
+
+  i = (size_t)0;
+#ifdef HASH_HAVE_X86_SIMD
+  if (hash_family == HASH_FAMILY_FAST) {
+    switch (get_simd_level()) {
+      case SIMD_AVX2:
+        i = avx2_hash_mem_batch(ptrs, lens, hashes, n);
+        break;
+      case SIMD_SSE42:
+        i = sse_hash_mem_batch(ptrs, lens, hashes, n);
+        break;
+      default:
+        break;
+    }
+  }
+#endif
+
+  for (; i < n; i++) hashes[i] = hash_mem(ptrs[i], lens[i]);
+}
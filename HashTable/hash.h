@@ -2,6 +2,34 @@
 #define __HASH_H__
 
 #include <stdint.h>
+#include <stdlib.h>
+
+/* Family of functions behind the hash_* entry points.
+
+   HASH_FAMILY_FAST mixes 8 bytes at a time with a 64-bit
+   multiply and a fold of the high half into the low half,
+   and finishes with a 64-bit avalanche step. It is the
+   default.
+
+   HASH_FAMILY_STRONG is the universal hash family
+   x -> (A * x + B) mod (2^64 - 257), combined word by word.
+   It is several times slower.
+*/
+typedef enum {
+  HASH_FAMILY_FAST,
+  HASH_FAMILY_STRONG
+} hash_family_t;
+
+/* Selects the family used by all hash_* functions.
+
+   All hashes stored in a data structure must have been
+   computed with the same family: change the family only
+   while no such data structure is in use.
+*/
+void set_hash_family(hash_family_t);
+
+/* Returns the family currently used by the hash_* functions */
+hash_family_t get_hash_family(void);
 
 uint32_t hash_uint64(uint64_t);
 uint32_t hash_int64(int64_t);
@@ -16,4 +44,41 @@ uint32_t hash_float(float);
 uint32_t hash_mem(const void *, size_t);
 uint32_t hash_str(const char *);
 
+/* Returns a 64-bit hash of a memory area, whose low 32 bits
+   are hash_mem(ptr, n), for keys sets large enough that 32-bit
+   hashes collide. With the strong family, the high 32 bits are
+   what hash_mem returns with the fast family.
+*/
+uint64_t hash_mem64(const void *, size_t);
+
+/* Hashes a NUL-terminated string in a single pass, 8 bytes at
+   a time, and stores its length (as strlen would return it)
+   in len, if len is not NULL.
+
+   Returns the same hash as hash_mem(str, strlen(str)).
+
+   May read up to 7 bytes past the terminating NUL, but
+   never across a page boundary.
+*/
+uint32_t hash_str_len(const char *, size_t *len);
+
+/* Hashes the n integers in keys, storing hash_uint64(keys[i])
+   in hashes[i].
+
+   With the fast family, several keys are hashed at once with
+   AVX2 or SSE4.2 when the processor supports it, chosen at run
+   time. Results are identical to the scalar functions.
+*/
+void hash_uint64_batch(const uint64_t *keys, uint32_t *hashes, size_t n);
+
+/* Hashes the n memory areas ptrs[i] of lens[i] bytes, storing
+   hash_mem(ptrs[i], lens[i]) in hashes[i].
+
+   With the fast family, several areas are hashed at once with
+   AVX2 or SSE4.2 when the processor supports it, chosen at run
+   time. Results are identical to the scalar functions.
+*/
+void hash_mem_batch(const void *const *ptrs, const size_t *lens,
+                    uint32_t *hashes, size_t n);
+
 #endif
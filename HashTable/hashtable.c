@@ -1,22 +1,80 @@
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "allocator.h"
+#include "bloom.h"
 #include "hashtable.h"
 #include "linkedlists.h"
 
+/* hash caches the hash of the key, so that keys with another
+   hash are told apart without calling compare_keys and entries
+   are migrated without calling hash_key
+*/
 typedef struct __hashtable_entry_struct_t {
   void *key;
   void *value;
+  uint32_t hash;
 } __hashtable_entry_t;
 
-static void error_no_mem(void) {
-  fprintf(stderr, "Error: no memory left.\n");
-  exit(1);
+/* Number of old buckets migrated by each add or remove
+   while the hashtable is being resized
+*/
+#define MIGRATE_BUCKETS ((size_t)8)
+
+/* Initial number of chain lengths counted, grown when a
+   longer chain shows up
+*/
+#define MIN_CHAIN_LENGTHS ((size_t)8)
+
+/* Number of keys lookup_many_in_hashtable has in flight at a
+   time, about the number of cache misses a core can wait for
+   at once
+*/
+#define LOOKUP_GROUP ((size_t)16)
+
+#if defined(__GNUC__)
+#define PREFETCH(p) __builtin_prefetch((p), 0, 3)
+#else
+#define PREFETCH(p) ((void)(p))
+#endif
+
+static list_t **__alloc_hashtable_buckets(allocator_t *allocator, size_t n) {
+  size_t i;
+  list_t **table;
+
+  table = (list_t **)allocate_zeroed_memory(allocator, n, sizeof(list_t *));
+
+  for (i = ((size_t)0); i < n; ++i) {
+    table[i] = NULL;
+  }
+
+  return table;
+}
+
+static uint32_t *__alloc_hashtable_lengths(allocator_t *allocator, size_t n) {
+  size_t i;
+  uint32_t *lengths;
+
+  lengths =
+      (uint32_t *)allocate_zeroed_memory(allocator, n, sizeof(uint32_t));
+
+  for (i = ((size_t)0); i < n; ++i) {
+    lengths[i] = (uint32_t)0;
+  }
+
+  return lengths;
 }
 
 hashtable_t *create_hashtable(size_t const size) {
-  size_t n, i;
+  return create_hashtable_with_allocator(size, NULL);
+}
+
+hashtable_t *create_hashtable_with_allocator(size_t const size,
+                                             allocator_t *allocator) {
+  size_t n;
   hashtable_t *hashtable;
 
   n = size;
@@ -24,21 +82,134 @@ hashtable_t *create_hashtable(size_t const size) {
     n = (size_t)1;
   }
 
-  hashtable = (hashtable_t *)calloc(1, sizeof(hashtable_t));
-  if (hashtable == NULL) error_no_mem();
+  hashtable =
+      (hashtable_t *)allocate_zeroed_memory(allocator, 1, sizeof(hashtable_t));
 
+  hashtable->allocator = allocator;
   hashtable->size = n;
-  hashtable->table = (list_t **)calloc(hashtable->size, sizeof(list_t *));
-  if (hashtable->table == NULL) {
-    free(hashtable);
-    error_no_mem();
+  hashtable->table = __alloc_hashtable_buckets(allocator, hashtable->size);
+  hashtable->number_entries = (size_t)0;
+  hashtable->min_size = n;
+  hashtable->load_factor = HASHTABLE_DEFAULT_LOAD_FACTOR;
+  hashtable->old_table = NULL;
+  hashtable->old_size = (size_t)0;
+  hashtable->migrated = (size_t)0;
+  hashtable->lengths = __alloc_hashtable_lengths(allocator, hashtable->size);
+  hashtable->old_lengths = NULL;
+  hashtable->used_buckets = (size_t)0;
+  hashtable->old_used_buckets = (size_t)0;
+  hashtable->number_chain_lengths = MIN_CHAIN_LENGTHS;
+  hashtable->chain_lengths = (size_t *)allocate_zeroed_memory(
+      allocator, hashtable->number_chain_lengths, sizeof(size_t));
+  hashtable->max_chain_length = (size_t)0;
+  hashtable->filter = NULL;
+  hashtable->filter_false_positive_rate = 0.0;
+  hashtable->chain_order = HASHTABLE_CHAIN_ORDER_FIXED;
+  hashtable->count_lookups = 0;
+  atomic_init(&(hashtable->lookups), (size_t)0);
+  atomic_init(&(hashtable->lookup_comparisons), (size_t)0);
+
+  return hashtable;
+}
+
+/* Returns the bucket an entry with the given hash lives in,
+   taking a resizing in progress into account.
+*/
+static list_t **__hashtable_bucket(hashtable_t *hashtable, uint32_t hash) {
+  size_t idx;
+
+  if (hashtable->old_table != NULL) {
+    idx = ((size_t)hash) % hashtable->old_size;
+    if (idx >= hashtable->migrated) return &(hashtable->old_table[idx]);
   }
 
-  for (i = ((size_t)0); i < hashtable->size; ++i) {
-    hashtable->table[i] = NULL;
+  return &(hashtable->table[((size_t)hash) % hashtable->size]);
+}
+
+/* Same as __hashtable_bucket, also returning the length of the
+   bucket and the number of non-empty buckets of its table.
+*/
+static list_t **__hashtable_bucket_counters(hashtable_t *hashtable,
+                                            uint32_t hash, uint32_t **length,
+                                            size_t **used_buckets) {
+  size_t idx;
+
+  if (hashtable->old_table != NULL) {
+    idx = ((size_t)hash) % hashtable->old_size;
+    if (idx >= hashtable->migrated) {
+      *length = &(hashtable->old_lengths[idx]);
+      *used_buckets = &(hashtable->old_used_buckets);
+      return &(hashtable->old_table[idx]);
+    }
   }
 
-  return hashtable;
+  idx = ((size_t)hash) % hashtable->size;
+  *length = &(hashtable->lengths[idx]);
+  *used_buckets = &(hashtable->used_buckets);
+  return &(hashtable->table[idx]);
+}
+
+/* Makes chain_lengths long enough to be indexed by length */
+static void __grow_hashtable_chain_lengths(hashtable_t *hashtable,
+                                           size_t length) {
+  size_t i, n;
+  size_t *chain_lengths;
+
+  n = hashtable->number_chain_lengths << 1;
+  if (n <= length) n = length + ((size_t)1);
+
+  chain_lengths =
+      (size_t *)allocate_zeroed_memory(hashtable->allocator, n, sizeof(size_t));
+  for (i = ((size_t)0); i < n; ++i) {
+    chain_lengths[i] = (i < hashtable->number_chain_lengths)
+                           ? hashtable->chain_lengths[i]
+                           : ((size_t)0);
+  }
+
+  free_memory(hashtable->allocator, hashtable->chain_lengths,
+              hashtable->number_chain_lengths * sizeof(size_t));
+  hashtable->chain_lengths = chain_lengths;
+  hashtable->number_chain_lengths = n;
+}
+
+/* Updates the counters for an entry added to a bucket */
+static void __count_added_to_bucket(hashtable_t *hashtable, uint32_t *length,
+                                    size_t *used_buckets) {
+  if (*length == ((uint32_t)0)) {
+    (*used_buckets)++;
+  } else {
+    hashtable->chain_lengths[*length]--;
+  }
+  (*length)++;
+
+  if (((size_t)*length) >= hashtable->number_chain_lengths) {
+    __grow_hashtable_chain_lengths(hashtable, (size_t)*length);
+  }
+  hashtable->chain_lengths[*length]++;
+  if (((size_t)*length) > hashtable->max_chain_length) {
+    hashtable->max_chain_length = (size_t)*length;
+  }
+}
+
+/* Updates the counters for an entry removed from a bucket. As
+   the bucket keeps length - 1 entries, the longest chain is
+   at most one entry shorter afterwards.
+*/
+static void __count_removed_from_bucket(hashtable_t *hashtable,
+                                        uint32_t *length,
+                                        size_t *used_buckets) {
+  hashtable->chain_lengths[*length]--;
+  if ((((size_t)*length) == hashtable->max_chain_length) &&
+      (hashtable->chain_lengths[*length] == ((size_t)0))) {
+    hashtable->max_chain_length--;
+  }
+  (*length)--;
+
+  if (*length == ((uint32_t)0)) {
+    (*used_buckets)--;
+  } else {
+    hashtable->chain_lengths[*length]++;
+  }
 }
 
 static void __delete_hashtable_entry(void *entry, void *data) {
@@ -47,11 +218,12 @@ static void __delete_hashtable_entry(void *entry, void *data) {
     void (*delete_key)(void *, void *);
     void (*delete_value)(void *, void *);
     void *data;
+    allocator_t *allocator;
   } *pvt_data = data;
 
   pvt_data->delete_key(pvt_entry->key, pvt_data->data);
   pvt_data->delete_value(pvt_entry->value, pvt_data->data);
-  free(entry);
+  free_memory(pvt_data->allocator, entry, sizeof(__hashtable_entry_t));
 }
 
 void delete_hashtable(hashtable_t *hashtable,
@@ -62,20 +234,39 @@ void delete_hashtable(hashtable_t *hashtable,
     void (*delete_key)(void *, void *);
     void (*delete_value)(void *, void *);
     void *data;
+    allocator_t *allocator;
   } mydata;
 
   mydata.delete_key = delete_key;
   mydata.delete_value = delete_value;
   mydata.data = data;
+  mydata.allocator = hashtable->allocator;
 
   for (i = ((size_t)0); i < hashtable->size; ++i) {
     if (hashtable->table[i] != NULL) {
       delete_list(hashtable->table[i], __delete_hashtable_entry, &mydata);
     }
   }
+  if (hashtable->old_table != NULL) {
+    for (i = hashtable->migrated; i < hashtable->old_size; ++i) {
+      if (hashtable->old_table[i] != NULL) {
+        delete_list(hashtable->old_table[i], __delete_hashtable_entry, &mydata);
+      }
+    }
+    free_memory(hashtable->allocator, hashtable->old_table,
+                hashtable->old_size * sizeof(list_t *));
+    free_memory(hashtable->allocator, hashtable->old_lengths,
+                hashtable->old_size * sizeof(uint32_t));
+  }
 
-  free(hashtable->table);
-  free(hashtable);
+  free_memory(hashtable->allocator, hashtable->table,
+              hashtable->size * sizeof(list_t *));
+  free_memory(hashtable->allocator, hashtable->lengths,
+              hashtable->size * sizeof(uint32_t));
+  free_memory(hashtable->allocator, hashtable->chain_lengths,
+              hashtable->number_chain_lengths * sizeof(size_t));
+  if (hashtable->filter != NULL) delete_bloom_filter(hashtable->filter);
+  free_memory(hashtable->allocator, hashtable, sizeof(hashtable_t));
 }
 
 static int __compare_hashtable_entry(void *a, void *b, void *data) {
@@ -86,125 +277,634 @@ static int __compare_hashtable_entry(void *a, void *b, void *data) {
   __hashtable_entry_t *pvt_a = a;
   __hashtable_entry_t *pvt_b = b;
 
+  if (pvt_a->hash != pvt_b->hash) return 1;
+
   return pvt_data->compare_keys(pvt_a->key, pvt_b->key, pvt_data->data);
 }
 
+/* Adds n to a counter that only the lookups change, which
+   several readers may change at the same time
+*/
+static void __count_hashtable_lookup(atomic_size_t *counter, size_t n) {
+  atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+/* Searches a chain from its head for an entry with the given
+   hash whose key compares equal to the given key, counting the
+   entries compared, and reorders the chain around the node
+   found as the chain order of the hashtable asks for. Returns
+   that entry, or NULL if there is none.
+
+   The node found is the first one holding its key, so that
+   moving it forward never passes an entry with an equal key.
+*/
+static __hashtable_entry_t *__search_hashtable_chain(
+    hashtable_t *hashtable, list_t *list, void *key, uint32_t hash,
+    int (*compare_keys)(void *, void *, void *), void *data) {
+  node_t *curr, *prev;
+  __hashtable_entry_t *entry;
+  size_t comparisons;
+
+  comparisons = (size_t)0;
+  for (curr = list->head; curr != NULL; curr = curr->next) {
+    comparisons++;
+    entry = curr->data;
+    if ((entry->hash == hash) && (compare_keys(key, entry->key, data) == 0)) {
+      break;
+    }
+  }
+  if ((hashtable->chain_order != HASHTABLE_CHAIN_ORDER_FIXED) ||
+      hashtable->count_lookups) {
+    __count_hashtable_lookup(&(hashtable->lookups), (size_t)1);
+    __count_hashtable_lookup(&(hashtable->lookup_comparisons), comparisons);
+  }
+
+  if (curr == NULL) return NULL;
+
+  if (curr->prev != NULL) {
+    switch (hashtable->chain_order) {
+      case HASHTABLE_CHAIN_ORDER_MOVE_TO_FRONT:
+        unlink_node(list, curr);
+        link_after(list, NULL, curr);
+        break;
+      case HASHTABLE_CHAIN_ORDER_TRANSPOSE:
+        prev = curr->prev->prev;
+        unlink_node(list, curr);
+        link_after(list, prev, curr);
+        break;
+      default:
+        break;
+    }
+  }
+
+  return curr->data;
+}
+
 void *lookup_in_hashtable(hashtable_t *hashtable, void *key,
                           uint32_t (*hash_key)(void *, void *),
                           int (*compare_keys)(void *, void *, void *),
                           void *data) {
-  uint32_t hash;
-  size_t idx;
+  return lookup_hashed_in_hashtable(hashtable, key, hash_key(key, data),
+                                    compare_keys, data);
+}
+
+void *lookup_hashed_in_hashtable(hashtable_t *hashtable, void *key,
+                                 uint32_t hash,
+                                 int (*compare_keys)(void *, void *, void *),
+                                 void *data) {
+  list_t **bucket;
   __hashtable_entry_t *entry;
-  struct __hashtable_entry_struct_t sought_entry;
-  struct {
-    int (*compare_keys)(void *, void *, void *);
-    void *data;
-  } mydata;
 
-  hash = hash_key(key, data);
-  idx = ((size_t)hash) % hashtable->size;
+  if ((hashtable->filter != NULL) &&
+      (!lookup_in_bloom_filter(hashtable->filter, hash))) {
+    return NULL;
+  }
 
-  if (hashtable->table[idx] == NULL) return NULL;
+  bucket = __hashtable_bucket(hashtable, hash);
 
-  sought_entry.key = key;
-  sought_entry.value = NULL;
-  mydata.compare_keys = compare_keys;
-  mydata.data = data;
+  if (*bucket == NULL) return NULL;
 
-  entry = search_list(hashtable->table[idx], &sought_entry,
-                      __compare_hashtable_entry, &mydata);
+  entry = __search_hashtable_chain(hashtable, *bucket, key, hash, compare_keys,
+                                   data);
 
   if (entry == NULL) return NULL;
 
   return entry->value;
 }
 
+/* Looks up the keys group by group. Each stage issues the
+   prefetches for the next level of indirection of all keys of
+   the group, bucket pointer, list, first node, first entry
+   and first key, before any of them is waited for, so that
+   the cache misses of the group overlap instead of following
+   one another. With a filter, the filter blocks are fetched
+   first and the keys it rejects skip all the other stages.
+
+   The chains are searched from their heads rather than from
+   the nodes prefetched, as a lookup of the group that reorders
+   a chain may have moved another node in front of them.
+*/
+void lookup_many_in_hashtable(hashtable_t *hashtable, void **keys, size_t n,
+                              void **results,
+                              uint32_t (*hash_key)(void *, void *),
+                              int (*compare_keys)(void *, void *, void *),
+                              void *data) {
+  size_t i, j, m;
+  uint32_t hashes[LOOKUP_GROUP];
+  list_t **buckets[LOOKUP_GROUP];
+  node_t *nodes[LOOKUP_GROUP];
+  __hashtable_entry_t *entry;
+
+  for (i = ((size_t)0); i < n; i += m) {
+    m = n - i;
+    if (m > LOOKUP_GROUP) m = LOOKUP_GROUP;
+
+    for (j = ((size_t)0); j < m; j++) {
+      hashes[j] = hash_key(keys[i + j], data);
+      if (hashtable->filter != NULL) {
+        prefetch_in_bloom_filter(hashtable->filter, hashes[j]);
+      }
+    }
+    for (j = ((size_t)0); j < m; j++) {
+      if ((hashtable->filter != NULL) &&
+          (!lookup_in_bloom_filter(hashtable->filter, hashes[j]))) {
+        buckets[j] = NULL;
+      } else {
+        buckets[j] = __hashtable_bucket(hashtable, hashes[j]);
+        PREFETCH(buckets[j]);
+      }
+    }
+    for (j = ((size_t)0); j < m; j++) {
+      if ((buckets[j] != NULL) && (*(buckets[j]) != NULL)) {
+        PREFETCH(*(buckets[j]));
+      }
+    }
+    for (j = ((size_t)0); j < m; j++) {
+      nodes[j] = (((buckets[j] == NULL) || (*(buckets[j]) == NULL))
+                      ? NULL
+                      : (*(buckets[j]))->head);
+      if (nodes[j] != NULL) PREFETCH(nodes[j]);
+    }
+    for (j = ((size_t)0); j < m; j++) {
+      if (nodes[j] != NULL) PREFETCH(nodes[j]->data);
+    }
+    for (j = ((size_t)0); j < m; j++) {
+      if (nodes[j] != NULL) {
+        entry = nodes[j]->data;
+        PREFETCH(entry->key);
+      }
+    }
+
+    for (j = ((size_t)0); j < m; j++) {
+      results[i + j] = NULL;
+      if (nodes[j] != NULL) {
+        entry = __search_hashtable_chain(hashtable, *(buckets[j]), keys[i + j],
+                                         hashes[j], compare_keys, data);
+        if (entry != NULL) results[i + j] = entry->value;
+      }
+    }
+  }
+}
+
 static void *__copy_hashtable_entry(void *entry, void *data) {
   struct {
     void *(*copy_key)(void *, void *);
     void *(*copy_value)(void *, void *);
     void *data;
+    allocator_t *allocator;
   } *pvt_data = data;
   __hashtable_entry_t *pvt_entry = entry;
   __hashtable_entry_t *new_entry;
 
-  new_entry = (__hashtable_entry_t *)calloc(1, sizeof(__hashtable_entry_t));
-  if (new_entry == NULL) error_no_mem();
+  new_entry = (__hashtable_entry_t *)allocate_memory(
+      pvt_data->allocator, sizeof(__hashtable_entry_t));
 
   new_entry->key = pvt_data->copy_key(pvt_entry->key, pvt_data->data);
   new_entry->value = pvt_data->copy_value(pvt_entry->value, pvt_data->data);
+  new_entry->hash = pvt_entry->hash;
 
   return new_entry;
 }
 
-void add_to_hashtable(hashtable_t *hashtable, void *key, void *value,
-                      void *(*copy_key)(void *, void *),
-                      void *(*copy_value)(void *, void *),
-                      uint32_t (*hash_key)(void *, void *), void *data) {
-  uint32_t hash;
+static void __delete_migrated_entry(void *entry, void *data) {}
+
+/* Moves a node of the old table bucket migrated to the tail of
+   its bucket in the new table without allocating. Appending
+   keeps entries with equal keys in the order they have been
+   added in.
+*/
+static void __migrate_hashtable_node(hashtable_t *hashtable, list_t *old_list,
+                                     node_t *node) {
+  __hashtable_entry_t *entry = node->data;
+  list_t *list;
   size_t idx;
+
+  __count_removed_from_bucket(hashtable,
+                              &(hashtable->old_lengths[hashtable->migrated]),
+                              &(hashtable->old_used_buckets));
+
+  idx = ((size_t)entry->hash) % hashtable->size;
+  __count_added_to_bucket(hashtable, &(hashtable->lengths[idx]),
+                          &(hashtable->used_buckets));
+  if (hashtable->table[idx] == NULL) {
+    hashtable->table[idx] = create_list_with_allocator(hashtable->allocator);
+  }
+  list = hashtable->table[idx];
+
+  unlink_node(old_list, node);
+  link_after(list, list->tail, node);
+}
+
+/* Migrates at most max_buckets buckets of the old table to
+   the new one. Frees the old table once it is empty.
+*/
+static void __migrate_hashtable_buckets(hashtable_t *hashtable,
+                                        size_t max_buckets) {
+  size_t k;
+  list_t *list;
+  node_t *curr, *next;
+
+  if (hashtable->old_table == NULL) return;
+
+  for (k = ((size_t)0);
+       (k < max_buckets) && (hashtable->migrated < hashtable->old_size); ++k) {
+    list = hashtable->old_table[hashtable->migrated];
+    if (list != NULL) {
+      for (curr = list->head; curr != NULL; curr = next) {
+        next = curr->next;
+        __migrate_hashtable_node(hashtable, list, curr);
+      }
+      delete_list(list, __delete_migrated_entry, NULL);
+      hashtable->old_table[hashtable->migrated] = NULL;
+    }
+    hashtable->migrated++;
+  }
+
+  if (hashtable->migrated >= hashtable->old_size) {
+    free_memory(hashtable->allocator, hashtable->old_table,
+                hashtable->old_size * sizeof(list_t *));
+    free_memory(hashtable->allocator, hashtable->old_lengths,
+                hashtable->old_size * sizeof(uint32_t));
+    hashtable->old_table = NULL;
+    hashtable->old_lengths = NULL;
+    hashtable->old_size = (size_t)0;
+    hashtable->migrated = (size_t)0;
+  }
+}
+
+/* Starts migrating all entries to a new table of new_size
+   buckets, finishing any previous migration first.
+*/
+static void __start_hashtable_resize(hashtable_t *hashtable,
+                                     size_t new_size) {
+  __migrate_hashtable_buckets(hashtable, SIZE_MAX);
+
+  hashtable->old_table = hashtable->table;
+  hashtable->old_lengths = hashtable->lengths;
+  hashtable->old_size = hashtable->size;
+  hashtable->old_used_buckets = hashtable->used_buckets;
+  hashtable->migrated = (size_t)0;
+  hashtable->table = __alloc_hashtable_buckets(hashtable->allocator, new_size);
+  hashtable->lengths = __alloc_hashtable_lengths(hashtable->allocator, new_size);
+  hashtable->used_buckets = (size_t)0;
+  hashtable->size = new_size;
+}
+
+/* Returns the number of buckets needed to hold the given
+   number of entries at the target load factor
+*/
+static size_t __hashtable_size_for(hashtable_t *hashtable,
+                                   size_t number_entries) {
+  double n;
+
+  n = ((double)number_entries) / hashtable->load_factor;
+  if (n >= ((double)SIZE_MAX)) return SIZE_MAX;
+
+  return (size_t)n + ((size_t)1);
+}
+
+/* Makes progress on a resizing in progress or starts one if
+   the load is out of bounds, as seen by an operation about to
+   leave number_entries entries in the table.
+*/
+static void __resize_hashtable_step(hashtable_t *hashtable,
+                                    size_t number_entries) {
+  size_t new_size;
+
+  if (hashtable->old_table != NULL) {
+    __migrate_hashtable_buckets(hashtable, MIGRATE_BUCKETS);
+    return;
+  }
+
+  if (((double)number_entries) >
+      (hashtable->load_factor * ((double)hashtable->size))) {
+    new_size = hashtable->size << 1;
+    if (new_size < __hashtable_size_for(hashtable, number_entries)) {
+      new_size = __hashtable_size_for(hashtable, number_entries);
+    }
+  } else if ((hashtable->size > hashtable->min_size) &&
+             ((((double)number_entries) * 4.0) <
+              (hashtable->load_factor * ((double)hashtable->size)))) {
+    new_size = hashtable->size >> 1;
+    if (new_size < hashtable->min_size) new_size = hashtable->min_size;
+  } else {
+    return;
+  }
+
+  __start_hashtable_resize(hashtable, new_size);
+  __migrate_hashtable_buckets(hashtable, MIGRATE_BUCKETS);
+}
+
+static void __add_entry_to_hashtable_filter(void *entry, void *data) {
+  __hashtable_entry_t *pvt_entry = entry;
+
+  add_to_bloom_filter((bloom_filter_t *)data, pvt_entry->hash);
+}
+
+/* Empties the filter, sizes it for twice the number of entries
+   given in argument, and adds the hashes of all entries to it
+*/
+static void __rebuild_hashtable_filter(hashtable_t *hashtable,
+                                       size_t number_entries) {
+  size_t i, capacity;
+
+  capacity = number_entries;
+  if (capacity < hashtable->number_entries) {
+    capacity = hashtable->number_entries;
+  }
+  if (capacity < ((size_t)1)) capacity = (size_t)1;
+  resize_bloom_filter(hashtable->filter, capacity << 1);
+
+  for (i = ((size_t)0); i < hashtable->size; ++i) {
+    if (hashtable->table[i] != NULL) {
+      iterate_over_list(hashtable->table[i], __add_entry_to_hashtable_filter,
+                        hashtable->filter);
+    }
+  }
+  if (hashtable->old_table != NULL) {
+    for (i = hashtable->migrated; i < hashtable->old_size; ++i) {
+      if (hashtable->old_table[i] != NULL) {
+        iterate_over_list(hashtable->old_table[i],
+                          __add_entry_to_hashtable_filter, hashtable->filter);
+      }
+    }
+  }
+}
+
+static void __add_hashed_to_hashtable(hashtable_t *hashtable, void *key,
+                                      void *value, uint32_t hash,
+                                      void *(*copy_key)(void *, void *),
+                                      void *(*copy_value)(void *, void *),
+                                      void *data) {
+  list_t **bucket;
+  uint32_t *length;
+  size_t *used_buckets;
   struct __hashtable_entry_struct_t added_entry;
   struct {
     void *(*copy_key)(void *, void *);
     void *(*copy_value)(void *, void *);
     void *data;
+    allocator_t *allocator;
   } mydata;
 
-  hash = hash_key(key, data);
-  idx = ((size_t)hash) % hashtable->size;
+  bucket = __hashtable_bucket_counters(hashtable, hash, &length, &used_buckets);
 
-  if (hashtable->table[idx] == NULL) {
-    hashtable->table[idx] = create_list();
+  if (*bucket == NULL) {
+    *bucket = create_list_with_allocator(hashtable->allocator);
   }
 
   added_entry.key = key;
   added_entry.value = value;
+  added_entry.hash = hash;
   mydata.copy_key = copy_key;
   mydata.copy_value = copy_value;
   mydata.data = data;
+  mydata.allocator = hashtable->allocator;
+
+  prepend_to_list(*bucket, &added_entry, __copy_hashtable_entry, &mydata);
+  hashtable->number_entries++;
+  __count_added_to_bucket(hashtable, length, used_buckets);
+
+  if (hashtable->filter != NULL) {
+    if (number_keys_in_bloom_filter(hashtable->filter) >=
+        capacity_of_bloom_filter(hashtable->filter)) {
+      __rebuild_hashtable_filter(hashtable, hashtable->number_entries);
+    } else {
+      add_to_bloom_filter(hashtable->filter, hash);
+    }
+  }
+}
+
+void add_to_hashtable(hashtable_t *hashtable, void *key, void *value,
+                      void *(*copy_key)(void *, void *),
+                      void *(*copy_value)(void *, void *),
+                      uint32_t (*hash_key)(void *, void *), void *data) {
+  uint32_t hash;
+
+  __resize_hashtable_step(hashtable, hashtable->number_entries + ((size_t)1));
 
-  prepend_to_list(hashtable->table[idx], &added_entry, __copy_hashtable_entry,
-                  &mydata);
+  hash = hash_key(key, data);
+  __add_hashed_to_hashtable(hashtable, key, value, hash, copy_key, copy_value,
+                            data);
 }
 
-size_t number_entries_in_hashtable(hashtable_t *hashtable) {
-  size_t i, k, l;
+void add_hashed_to_hashtable(hashtable_t *hashtable, void *key, void *value,
+                             uint32_t hash, void *(*copy_key)(void *, void *),
+                             void *(*copy_value)(void *, void *),
+                             void *data) {
+  __resize_hashtable_step(hashtable, hashtable->number_entries + ((size_t)1));
 
-  k = (size_t)0;
-  for (i = ((size_t)0); i < hashtable->size; ++i) {
-    if (hashtable->table[i] != NULL) {
-      l = length_list(hashtable->table[i]);
-      k += l;
-    }
+  __add_hashed_to_hashtable(hashtable, key, value, hash, copy_key, copy_value,
+                            data);
+}
+
+/* Removes the first node of a list holding an entry with the
+   given hash whose key compares equal to the given key. Returns
+   that entry, or NULL if there is none.
+*/
+static __hashtable_entry_t *__unlink_hashtable_entry(
+    list_t *list, void *key, uint32_t hash,
+    int (*compare_keys)(void *, void *, void *), void *data) {
+  node_t *node;
+  struct __hashtable_entry_struct_t sought_entry;
+  struct {
+    int (*compare_keys)(void *, void *, void *);
+    void *data;
+  } mydata;
+
+  sought_entry.key = key;
+  sought_entry.value = NULL;
+  sought_entry.hash = hash;
+  mydata.compare_keys = compare_keys;
+  mydata.data = data;
+
+  node = search_node_in_list(list, &sought_entry, __compare_hashtable_entry,
+                             &mydata);
+  if (node == NULL) return NULL;
+
+  return remove_node(list, node);
+}
+
+void remove_from_hashtable(hashtable_t *hashtable, void *key,
+                           uint32_t (*hash_key)(void *, void *),
+                           int (*compare_keys)(void *, void *, void *),
+                           void (*delete_key)(void *, void *),
+                           void (*delete_value)(void *, void *), void *data) {
+  remove_hashed_from_hashtable(hashtable, key, hash_key(key, data),
+                               compare_keys, delete_key, delete_value, data);
+}
+
+void remove_hashed_from_hashtable(hashtable_t *hashtable, void *key,
+                                  uint32_t hash,
+                                  int (*compare_keys)(void *, void *, void *),
+                                  void (*delete_key)(void *, void *),
+                                  void (*delete_value)(void *, void *),
+                                  void *data) {
+  uint32_t *length;
+  size_t *used_buckets;
+  list_t **bucket;
+  __hashtable_entry_t *entry;
+
+  bucket = __hashtable_bucket_counters(hashtable, hash, &length, &used_buckets);
+  if (*bucket == NULL) return;
+
+  entry = __unlink_hashtable_entry(*bucket, key, hash, compare_keys, data);
+  if (entry == NULL) return;
+
+  if (is_empty_list(*bucket)) {
+    delete_list(*bucket, __delete_migrated_entry, NULL);
+    *bucket = NULL;
   }
+  delete_key(entry->key, data);
+  delete_value(entry->value, data);
+  free_memory(hashtable->allocator, entry, sizeof(__hashtable_entry_t));
+  hashtable->number_entries--;
+  __count_removed_from_bucket(hashtable, length, used_buckets);
 
-  return k;
+  __resize_hashtable_step(hashtable, hashtable->number_entries);
 }
 
-size_t max_number_collisions_in_hashtable(hashtable_t *hashtable) {
-  size_t i, k, l;
+void reserve_hashtable(hashtable_t *hashtable, size_t number_entries) {
+  size_t new_size;
+
+  new_size = __hashtable_size_for(hashtable, number_entries);
+  if (new_size > hashtable->min_size) hashtable->min_size = new_size;
+
+  if (new_size > hashtable->size) {
+    __start_hashtable_resize(hashtable, new_size);
+  }
+  __migrate_hashtable_buckets(hashtable, SIZE_MAX);
+
+  if ((hashtable->filter != NULL) &&
+      (capacity_of_bloom_filter(hashtable->filter) < number_entries)) {
+    __rebuild_hashtable_filter(hashtable, number_entries);
+  }
+}
+
+void set_hashtable_load_factor(hashtable_t *hashtable, double load_factor) {
+  if (!(load_factor > 0.0)) return;
+
+  hashtable->load_factor = load_factor;
+}
+
+void set_hashtable_filter(hashtable_t *hashtable, double false_positive_rate) {
+  if (hashtable->filter != NULL) {
+    delete_bloom_filter(hashtable->filter);
+    hashtable->filter = NULL;
+    hashtable->filter_false_positive_rate = 0.0;
+  }
+  if (!((false_positive_rate > 0.0) && (false_positive_rate < 1.0))) return;
+
+  hashtable->filter_false_positive_rate = false_positive_rate;
+  hashtable->filter = create_bloom_filter((size_t)1, false_positive_rate,
+                                          hashtable->allocator);
+  __rebuild_hashtable_filter(hashtable, hashtable->number_entries);
+}
+
+void set_hashtable_chain_order(hashtable_t *hashtable,
+                               hashtable_chain_order_t chain_order) {
+  hashtable->chain_order = chain_order;
+}
+
+void set_hashtable_lookup_counting(hashtable_t *hashtable, int count_lookups) {
+  hashtable->count_lookups = count_lookups;
+}
+
+static void __iterate_hashtable_entry(void *entry, void *data) {
+  __hashtable_entry_t *pvt_entry = entry;
+  struct {
+    void (*f)(void *, void *, void *);
+    void *data;
+  } *pvt_data = data;
+
+  pvt_data->f(pvt_entry->key, pvt_entry->value, pvt_data->data);
+}
+
+void iterate_over_hashtable(hashtable_t *hashtable,
+                            void (*f)(void *, void *, void *), void *data) {
+  size_t i;
+  struct {
+    void (*f)(void *, void *, void *);
+    void *data;
+  } mydata;
+
+  mydata.f = f;
+  mydata.data = data;
 
-  k = (size_t)0;
   for (i = ((size_t)0); i < hashtable->size; ++i) {
     if (hashtable->table[i] != NULL) {
-      l = length_list(hashtable->table[i]);
-      if (l > k) k = l;
+      iterate_over_list(hashtable->table[i], __iterate_hashtable_entry,
+                        &mydata);
     }
   }
+  if (hashtable->old_table != NULL) {
+    for (i = hashtable->migrated; i < hashtable->old_size; ++i) {
+      if (hashtable->old_table[i] != NULL) {
+        iterate_over_list(hashtable->old_table[i], __iterate_hashtable_entry,
+                          &mydata);
+      }
+    }
+  }
+}
 
-  if (k == ((size_t)0)) return 0;
+size_t number_entries_in_hashtable(hashtable_t *hashtable) {
+  return hashtable->number_entries;
+}
+
+size_t max_number_collisions_in_hashtable(hashtable_t *hashtable) {
+  if (hashtable->max_chain_length == ((size_t)0)) return 0;
 
-  return k - ((size_t)1);
+  return hashtable->max_chain_length - ((size_t)1);
 }
 
 size_t number_empty_entries_in_hashtable(hashtable_t *hashtable) {
+  return hashtable->size - hashtable->used_buckets;
+}
+
+void get_hashtable_stats(hashtable_t *hashtable, hashtable_stats_t *stats) {
   size_t i, n;
 
-  n = (size_t)0;
-  for (i = ((size_t)0); i < hashtable->size; ++i) {
-    if (hashtable->table[i] == NULL) ++n;
+  stats->number_entries = hashtable->number_entries;
+  stats->number_buckets = hashtable->size;
+  stats->number_empty_buckets = number_empty_entries_in_hashtable(hashtable);
+  stats->max_chain_length = hashtable->max_chain_length;
+  stats->load_factor =
+      ((double)hashtable->number_entries) / ((double)hashtable->size);
+  stats->resizing = (hashtable->old_table != NULL);
+
+  for (i = ((size_t)0); i < HASHTABLE_STATS_CHAIN_LENGTHS; ++i) {
+    stats->chain_lengths[i] = (size_t)0;
+  }
+  stats->chain_lengths[0] = stats->number_empty_buckets;
+  for (i = ((size_t)1); i <= hashtable->max_chain_length; ++i) {
+    n = (i < HASHTABLE_STATS_CHAIN_LENGTHS)
+            ? i
+            : (HASHTABLE_STATS_CHAIN_LENGTHS - ((size_t)1));
+    stats->chain_lengths[n] += hashtable->chain_lengths[i];
+  }
+
+  stats->filter_lookups = (size_t)0;
+  stats->filter_rejections = (size_t)0;
+  if (hashtable->filter != NULL) {
+    stats->filter_lookups = number_lookups_in_bloom_filter(
+        hashtable->filter, &(stats->filter_rejections));
   }
 
-  return n;
+  stats->lookups =
+      atomic_load_explicit(&(hashtable->lookups), memory_order_relaxed);
+  stats->lookup_comparisons = atomic_load_explicit(
+      &(hashtable->lookup_comparisons), memory_order_relaxed);
+
+  stats->bytes_used =
+      sizeof(hashtable_t) +
+      hashtable->size * (sizeof(list_t *) + sizeof(uint32_t)) +
+      hashtable->old_size * (sizeof(list_t *) + sizeof(uint32_t)) +
+      hashtable->number_chain_lengths * sizeof(size_t) +
+      (hashtable->used_buckets + hashtable->old_used_buckets) *
+          sizeof(list_t) +
+      hashtable->number_entries *
+          (sizeof(node_t) + sizeof(__hashtable_entry_t)) +
+      ((hashtable->filter == NULL)
+           ? ((size_t)0)
+           : number_bytes_in_bloom_filter(hashtable->filter));
 }
@@ -1,22 +1,160 @@
 #ifndef __HASHTABLE_H__
 #define __HASHTABLE_H__
 
+#include <stdatomic.h>
 #include <stdint.h>
 
+#include "allocator.h"
+#include "bloom.h"
+#include "linkedlists.h"
+
+/* How a successful lookup reorders the chain of the entry it
+   finds. HASHTABLE_CHAIN_ORDER_FIXED leaves the chains alone:
+   they hold the most recently added entries first.
+   HASHTABLE_CHAIN_ORDER_MOVE_TO_FRONT moves the entry found to
+   the head of its chain, HASHTABLE_CHAIN_ORDER_TRANSPOSE swaps
+   it with the entry before it.
+*/
+typedef enum {
+  HASHTABLE_CHAIN_ORDER_FIXED,
+  HASHTABLE_CHAIN_ORDER_MOVE_TO_FRONT,
+  HASHTABLE_CHAIN_ORDER_TRANSPOSE
+} hashtable_chain_order_t;
+
 typedef struct __hashtable_struct_t {
   size_t size;
   list_t **table;
+  size_t number_entries;
+  size_t min_size;
+  double load_factor;
+  /* While the table is being resized, the buckets
+     old_table[migrated], ..., old_table[old_size - 1]
+     still hold their entries. old_table is NULL otherwise.
+  */
+  list_t **old_table;
+  size_t old_size;
+  size_t migrated;
+  /* Allocates the hashtable, its buckets, lists and entries,
+     NULL for malloc and free
+  */
+  allocator_t *allocator;
+  /* Number of entries in each bucket of table and old_table,
+     and number of non-empty buckets in each of them
+  */
+  uint32_t *lengths;
+  uint32_t *old_lengths;
+  size_t used_buckets;
+  size_t old_used_buckets;
+  /* chain_lengths[k] is the number of buckets of table and
+     old_table holding k entries, for 0 < k <= max_chain_length
+     < number_chain_lengths
+  */
+  size_t *chain_lengths;
+  size_t number_chain_lengths;
+  size_t max_chain_length;
+  /* Holds the hashes of all the keys added since it has been
+     built, NULL if the hashtable has no membership filter
+  */
+  bloom_filter_t *filter;
+  double filter_false_positive_rate;
+  /* How lookups reorder the chains, number of lookups that
+     have searched a chain and number of entries they have compared
+     the sought key to. The counters are only kept while the
+     chains are reordered or count_lookups is set, so that the
+     lookups of a fixed order hashtable never write to it.
+  */
+  hashtable_chain_order_t chain_order;
+  int count_lookups;
+  atomic_size_t lookups;
+  atomic_size_t lookup_comparisons;
 } hashtable_t;
 
+/* Number of chain lengths told apart by hashtable_stats_t */
+#define HASHTABLE_STATS_CHAIN_LENGTHS ((size_t)16)
+
+/* Statistics of a hashtable, all maintained as the hashtable
+   is modified.
+
+   chain_lengths[k] is the number of buckets holding k entries.
+   The last element counts all buckets holding at least
+   HASHTABLE_STATS_CHAIN_LENGTHS - 1 entries. A successful
+   lookup of the k-th entry of a chain compares k keys at most,
+   so the number of entries found after k probes is the number
+   of buckets holding at least k entries.
+
+   bytes_used is the memory held by the hashtable itself, its
+   buckets, lists, nodes and entries, excluding the keys and
+   values.
+
+   While a resize is in progress, number_buckets,
+   number_empty_buckets and chain_lengths[0] describe the new
+   table only, the other counts both tables.
+
+   filter_lookups is the number of lookups that have gone
+   through the membership filter, and filter_rejections the
+   number of them it has answered without reading any bucket.
+   Both are 0 if the hashtable has no filter.
+
+   lookups is the number of lookups that have searched a
+   chain, and lookup_comparisons the number of entries they have
+   compared the sought key to, by their cached hash or with
+   compare_keys. Their ratio is the average cost of a lookup
+   that the chain order in use tries to bring down. Both only
+   count the lookups made while the chains are reordered or
+   while set_hashtable_lookup_counting is on.
+*/
+typedef struct {
+  size_t number_entries;
+  size_t number_buckets;
+  size_t number_empty_buckets;
+  size_t max_chain_length;
+  double load_factor;
+  size_t bytes_used;
+  int resizing;
+  size_t chain_lengths[HASHTABLE_STATS_CHAIN_LENGTHS];
+  size_t filter_lookups;
+  size_t filter_rejections;
+  size_t lookups;
+  size_t lookup_comparisons;
+} hashtable_stats_t;
+
+/* Default target load factor, i.e. average number of entries
+   per bucket, of a hashtable.
+*/
+#define HASHTABLE_DEFAULT_LOAD_FACTOR (1.0)
+
 /* Create a hashtable of certain size given in argument.
 
    O(n)
 
    Creates a hashtable of size 1, if the size in
    argument is zero.
+
+   The hashtable grows when the number of entries exceeds the
+   target load factor times the number of buckets, and shrinks
+   when it falls below a quarter of that, but never below the
+   size given in argument. Resizing is incremental: every call
+   to add_to_hashtable or remove_from_hashtable migrates a
+   bounded number of buckets to the new table.
 */
 hashtable_t *create_hashtable(const size_t);
 
+/* Create a hashtable of certain size given in argument, like
+   create_hashtable, that allocates all its memory, except for
+   the keys and values, with the allocator in argument. The
+   allocator must outlive the hashtable.
+
+   O(n)
+
+   With the allocator of an arena, the hashtable need not be
+   deleted: deleting the arena releases it all at once. The
+   bucket arrays left behind by a resize are only released with
+   the arena, so such a hashtable is best sized up front with
+   reserve_hashtable.
+*/
+hashtable_t *create_hashtable_with_allocator(const size_t,
+                                             allocator_t *allocator);
+
 /* Delete a hashtable. Calls delete_key for each key and
    calls delete_value for each value.
 
@@ -30,8 +168,9 @@ void delete_hashtable(hashtable_t *hashtable,
                       void (*delete_value)(void *, void *), void *data);
 
 /* Lookup a key in a hashtable. Calls hash_key to compute
-   the hash. Calls compare_keys to compare the keys
-   in the collisions list with the given key.
+   the hash. Calls compare_keys to compare the keys in the
+   collisions list whose cached hash equals the hash of the
+   given key.
 
    O(1) if no collision, O(n) if collisions.
 
@@ -48,11 +187,47 @@ void *lookup_in_hashtable(hashtable_t *hashtable, void *key,
                           int (*compare_keys)(void *, void *, void *),
                           void *data);
 
+/* Lookup a key whose hash has already been computed in a
+   hashtable. Same as lookup_in_hashtable without the call to
+   hash_key.
+
+   O(1) if no collision, O(n) if collisions.
+
+   The data pointer is given back to the compare_keys
+   function as its last argument.
+*/
+void *lookup_hashed_in_hashtable(hashtable_t *hashtable, void *key,
+                                 uint32_t hash,
+                                 int (*compare_keys)(void *, void *, void *),
+                                 void *data);
+
+/* Lookup n keys in a hashtable at once, storing the value of
+   keys[i] into results[i], or NULL if keys[i] is not found.
+   Calls hash_key and compare_keys as lookup_in_hashtable does.
+
+   O(n) if no collisions.
+
+   Hashes a group of keys first and prefetches their buckets
+   and first entries before comparing any key, so that the
+   memory accesses of different keys overlap. Faster than n
+   calls to lookup_in_hashtable once the hashtable does not
+   fit into the caches.
+
+   The data pointer is given back to the hash_key
+   and compare_keys functions as their last argument.
+*/
+void lookup_many_in_hashtable(hashtable_t *hashtable, void **keys, size_t n,
+                              void **results,
+                              uint32_t (*hash_key)(void *, void *),
+                              int (*compare_keys)(void *, void *, void *),
+                              void *data);
+
 /* Add a key->value pair to a hashtable. Calls
    copy_key to copy the key. Calls copy_value to copy the
    value. Calls hash_key to compute the hash of the key.
 
-   O(1) if no collisions, O(n) if collisions.
+   O(1) amortized. Each entry caches the hash of its key,
+   so resizing the table never calls hash_key.
 
    The data pointer is given back to the copy_key, copy_value
    and hash_key functions as their last argument.
@@ -62,9 +237,139 @@ void add_to_hashtable(hashtable_t *hashtable, void *key, void *value,
                       void *(*copy_value)(void *, void *),
                       uint32_t (*hash_key)(void *, void *), void *data);
 
-/* Returns the number of entries in the hashtable
+/* Add a key->value pair whose hash has already been computed,
+   e.g. with hash_mem_batch, to a hashtable. Same as
+   add_to_hashtable without the call to hash_key.
+
+   O(1) amortized.
+
+   The data pointer is given back to the copy_key and
+   copy_value functions as their last argument.
+*/
+void add_hashed_to_hashtable(hashtable_t *hashtable, void *key, void *value,
+                             uint32_t hash, void *(*copy_key)(void *, void *),
+                             void *(*copy_value)(void *, void *), void *data);
+
+/* Remove a key from a hashtable. Calls hash_key to compute the
+   hash and compare_keys to find the key. Calls delete_key and
+   delete_value on the removed key and value.
+
+   If the same key has been added several times, only the
+   value added last is removed. Does nothing if the key is
+   not found.
+
+   O(1) if no collisions, O(n) if collisions.
+
+   The data pointer is given back to the hash_key, compare_keys,
+   delete_key and delete_value functions as their last argument.
+*/
+void remove_from_hashtable(hashtable_t *hashtable, void *key,
+                           uint32_t (*hash_key)(void *, void *),
+                           int (*compare_keys)(void *, void *, void *),
+                           void (*delete_key)(void *, void *),
+                           void (*delete_value)(void *, void *), void *data);
+
+/* Remove a key whose hash has already been computed from a
+   hashtable. Same as remove_from_hashtable without the call to
+   hash_key.
+
+   O(1) if no collisions, O(n) if collisions.
+
+   The data pointer is given back to the compare_keys,
+   delete_key and delete_value functions as their last argument.
+*/
+void remove_hashed_from_hashtable(hashtable_t *hashtable, void *key,
+                                  uint32_t hash,
+                                  int (*compare_keys)(void *, void *, void *),
+                                  void (*delete_key)(void *, void *),
+                                  void (*delete_value)(void *, void *),
+                                  void *data);
+
+/* Resize a hashtable at once so that it can hold the number
+   of entries given in argument at its target load factor,
+   and never shrinks below that. Finishes any incremental
+   resizing in progress. The entries are moved to the new
+   table by their cached hash, without calling hash_key.
+
+   O(n)
+
+   Intended for bulk loaders that know how many entries
+   they are about to add.
+*/
+void reserve_hashtable(hashtable_t *hashtable, size_t number_entries);
+
+/* Set the target load factor of a hashtable, i.e. the
+   average number of entries per bucket above which it grows.
+   Non-positive values are ignored.
+
+   O(1)
+
+   Takes effect on the next call to add_to_hashtable or
+   remove_from_hashtable.
+*/
+void set_hashtable_load_factor(hashtable_t *hashtable, double load_factor);
+
+/* Attach a membership filter, a blocked Bloom filter of the
+   cached hashes of the keys, to a hashtable, with the false
+   positive rate in argument. Lookups of keys that have never
+   been added are then mostly answered by the filter alone,
+   from a single cache line, without reading the bucket array.
+   A rate not strictly between 0 and 1 removes the filter.
+
+   O(n)
+
+   The filter is rebuilt from the cached hashes whenever the
+   number of keys added reaches its capacity, which is twice
+   the number of entries it has been built for. Removed keys
+   stay in the filter until then, so that they make lookups
+   slower but never wrong.
+*/
+void set_hashtable_filter(hashtable_t *hashtable, double false_positive_rate);
+
+/* Set how successful lookups reorder the chain of the entry
+   they find, HASHTABLE_CHAIN_ORDER_FIXED by default. With
+   skewed lookups, moving the entries found towards the head of
+   their chains brings the most looked up keys to the front, so
+   that they are found after fewer comparisons. Entries with
+   equal keys keep their relative order, so that a lookup still
+   finds the value added last.
+
+   O(1)
+
+   A hashtable whose chains are reordered is modified by its
+   lookups: it must then not be looked up by several threads at
+   the same time, even without writers.
+*/
+void set_hashtable_chain_order(hashtable_t *hashtable,
+                               hashtable_chain_order_t chain_order);
+
+/* Turn on, with a non-zero argument, or off the counting of
+   the lookups and of the entries they compare reported by
+   get_hashtable_stats, to measure the lookups of a hashtable
+   whose chains are not reordered. Lookups always count while
+   the chains are reordered.
+
+   O(1)
+
+   Counting makes every lookup write to the hashtable, which
+   slows down threads looking it up at the same time.
+*/
+void set_hashtable_lookup_counting(hashtable_t *hashtable, int count_lookups);
+
+/* Calls f on every key->value pair held in the hashtable,
+   in no particular order. The hashtable must not be modified
+   by f.
 
    O(n)
+
+   The data pointer is given back to f as its last argument.
+*/
+void iterate_over_hashtable(hashtable_t *hashtable,
+                            void (*f)(void *, void *, void *), void *data);
+
+/* Returns the number of entries in the hashtable
+
+   O(1)
 */
 size_t number_entries_in_hashtable(hashtable_t *hashtable);
 
@@ -75,14 +380,21 @@ size_t number_entries_in_hashtable(hashtable_t *hashtable);
    If the hashtable does have entries, returns the
    length of the longest collision list minus 1.
 
-   O(n)
+   O(1)
 */
 size_t max_number_collisions_in_hashtable(hashtable_t *hashtable);
 
 /* Returns the number of entries that are empty in hashtable.
 
-   O(n)
+   O(1)
 */
 size_t number_empty_entries_in_hashtable(hashtable_t *hashtable);
 
+/* Fills in the statistics of a hashtable, cheap enough to be
+   exported periodically.
+
+   O(1), or rather O(length of the longest collision list).
+*/
+void get_hashtable_stats(hashtable_t *hashtable, hashtable_stats_t *stats);
+
 #endif
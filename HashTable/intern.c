@@ -0,0 +1,115 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "hash.h"
+#include "intern.h"
+#include "oahashtable.h"
+
+/* Size of a slot of the open addressing hashtable: the hash,
+   the probe distance, the key and the value
+*/
+#define INTERN_SLOT_BYTES ((2 * sizeof(uint32_t)) + (2 * sizeof(void *)))
+
+/* Each canonical copy is both the key and the value of its
+   entry in table, and is allocated in arena
+*/
+struct __intern_pool_struct_t {
+  oa_hashtable_t *table;
+  arena_t *arena;
+  size_t number_interned;
+};
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+/* The length and hash of the string being interned, computed
+   once before the lookup
+*/
+typedef struct {
+  size_t len;
+  uint32_t hash;
+} __intern_key_t;
+
+static uint32_t __hash_interned_string(void *str, void *data) {
+  __intern_key_t *pvt_data = data;
+
+  return pvt_data->hash;
+}
+
+static int __compare_interned_strings(void *a, void *b, void *data) {
+  return strcmp((const char *)a, (const char *)b);
+}
+
+static void *__borrow_interned_string(void *str, void *data) { return str; }
+
+static void __delete_interned_string(void *str, void *data) {}
+
+intern_pool_t *create_intern_pool(void) {
+  intern_pool_t *pool;
+
+  pool = (intern_pool_t *)calloc(1, sizeof(intern_pool_t));
+  if (pool == NULL) error_no_mem();
+
+  pool->table = create_oa_hashtable((size_t)0);
+  pool->arena = create_arena((size_t)0);
+  pool->number_interned = (size_t)0;
+
+  return pool;
+}
+
+void delete_intern_pool(intern_pool_t *pool) {
+  delete_oa_hashtable(pool->table, __delete_interned_string,
+                      __delete_interned_string, NULL);
+  delete_arena(pool->arena);
+  free(pool);
+}
+
+const char *intern_string(intern_pool_t *pool, const char *str) {
+  __intern_key_t key;
+  char *copy;
+
+  pool->number_interned++;
+
+  key.hash = hash_str_len(str, &(key.len));
+  copy = lookup_in_oa_hashtable(pool->table, (void *)str,
+                                __hash_interned_string,
+                                __compare_interned_strings, &key);
+  if (copy != NULL) return copy;
+
+  copy = allocate_in_arena(pool->arena, key.len + ((size_t)1));
+  memcpy(copy, str, key.len + ((size_t)1));
+  add_hashed_to_oa_hashtable(pool->table, copy, copy, key.hash,
+                             __borrow_interned_string,
+                             __borrow_interned_string, NULL);
+
+  return copy;
+}
+
+const char *lookup_interned_string(intern_pool_t *pool, const char *str) {
+  __intern_key_t key;
+
+  key.hash = hash_str_len(str, &(key.len));
+
+  return lookup_in_oa_hashtable(pool->table, (void *)str,
+                                __hash_interned_string,
+                                __compare_interned_strings, &key);
+}
+
+size_t number_strings_in_intern_pool(intern_pool_t *pool) {
+  return number_entries_in_oa_hashtable(pool->table);
+}
+
+size_t number_interned_in_intern_pool(intern_pool_t *pool) {
+  return pool->number_interned;
+}
+
+size_t number_bytes_in_intern_pool(intern_pool_t *pool) {
+  return sizeof(intern_pool_t) + sizeof(oa_hashtable_t) +
+         pool->table->size * INTERN_SLOT_BYTES +
+         number_bytes_in_arena(pool->arena);
+}
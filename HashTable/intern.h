@@ -0,0 +1,67 @@
+#ifndef __INTERN_H__
+#define __INTERN_H__
+
+#include <stdlib.h>
+
+/* An intern pool holds one canonical copy of each distinct
+   string it has been given. Interning a string returns that
+   copy, so that equal strings are stored once and interned
+   strings can be compared for equality by their pointers.
+
+   The copies are allocated in an arena and looked up in an
+   open addressing hashtable, keyed by the copies themselves.
+   They live as long as the pool: there is no way to remove a
+   single string.
+
+   A pool must not be used by several threads at the same time.
+*/
+typedef struct __intern_pool_struct_t intern_pool_t;
+
+/* Create an empty intern pool
+
+   O(1)
+*/
+intern_pool_t *create_intern_pool(void);
+
+/* Delete an intern pool and all the strings interned in it
+
+   O(n)
+*/
+void delete_intern_pool(intern_pool_t *pool);
+
+/* Returns the canonical copy of a string, copying it into the
+   pool if no equal string has been interned yet. The copy is
+   never modified and stays valid until the pool is deleted.
+
+   O(length of the string) expected
+*/
+const char *intern_string(intern_pool_t *pool, const char *str);
+
+/* Returns the canonical copy of a string, or NULL if no equal
+   string has been interned. Never copies the string.
+
+   O(length of the string) expected
+*/
+const char *lookup_interned_string(intern_pool_t *pool, const char *str);
+
+/* Returns the number of distinct strings in the intern pool
+
+   O(1)
+*/
+size_t number_strings_in_intern_pool(intern_pool_t *pool);
+
+/* Returns the number of times intern_string has been called
+   on the intern pool, at least the number of distinct strings
+
+   O(1)
+*/
+size_t number_interned_in_intern_pool(intern_pool_t *pool);
+
+/* Returns the number of bytes the intern pool holds, its
+   arena and its hashtable
+
+   O(1)
+*/
+size_t number_bytes_in_intern_pool(intern_pool_t *pool);
+
+#endif
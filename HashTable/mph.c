@@ -0,0 +1,270 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "mph.h"
+
+/* The flat block is made of the words
+
+     MPH_MAGIC, hash family, number of keys, number of levels L,
+     number of words W of the bit arrays,
+     L + 1 level offsets: level l holds the bits of the words
+       level_offsets[l], ..., level_offsets[l + 1] - 1,
+     the W words of the bit arrays,
+     the (W + 7) / 8 32-bit ranks, two per word: rank b is
+       the number of bits set in the words before word 8 * b.
+*/
+#define MPH_MAGIC ((uint64_t)(0x3148504d48504d42ull))
+#define MPH_HEADER_WORDS ((size_t)5)
+#define MPH_MAX_LEVELS ((size_t)32)
+#define MPH_RANK_WORDS ((size_t)8)
+
+/* Odd constant the level number is spread with before being
+   mixed into the fingerprint
+*/
+#define MPH_LEVEL_SEED ((uint64_t)(0x9e3779b97f4a7c15ull))
+
+struct __mph_struct_t {
+  const uint64_t *block;
+  size_t len;
+  int owned;
+  size_t number_keys;
+  size_t number_levels;
+  const uint64_t *level_offsets;
+  const uint64_t *words;
+  const uint32_t *ranks;
+};
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+static size_t __popcount64(uint64_t w) {
+#if defined(__GNUC__)
+  return (size_t)__builtin_popcountll(w);
+#else
+  size_t n;
+
+  for (n = ((size_t)0); w != ((uint64_t)0); w &= w - ((uint64_t)1)) n++;
+
+  return n;
+#endif
+}
+
+/* Returns the bit a fingerprint sets in a level of number_bits
+   bits
+*/
+static size_t __mph_position(uint64_t fingerprint, size_t level,
+                             size_t number_bits) {
+  uint32_t h;
+
+  h = hash_uint64(fingerprint ^ (((uint64_t)(level + ((size_t)1))) *
+                                 MPH_LEVEL_SEED));
+
+  return (size_t)((((uint64_t)h) * ((uint64_t)number_bits)) >> 32);
+}
+
+static int __test_mph_bit(const uint64_t *words, size_t i) {
+  return (int)((words[i >> 6] >> (i & ((size_t)63))) & ((uint64_t)1));
+}
+
+static void __set_mph_bit(uint64_t *words, size_t i) {
+  words[i >> 6] |= ((uint64_t)1) << (i & ((size_t)63));
+}
+
+static size_t __mph_rank_count(size_t number_words) {
+  return (number_words + MPH_RANK_WORDS - ((size_t)1)) / MPH_RANK_WORDS;
+}
+
+/* Returns the number of words of the flat block */
+static size_t __mph_block_words(size_t number_levels, size_t number_words) {
+  return MPH_HEADER_WORDS + number_levels + ((size_t)1) + number_words +
+         ((__mph_rank_count(number_words) + ((size_t)1)) >> 1);
+}
+
+/* Sets the pointers of mph into its flat block */
+static void __map_mph_block(mph_t *mph) {
+  mph->number_keys = (size_t)mph->block[2];
+  mph->number_levels = (size_t)mph->block[3];
+  mph->level_offsets = &(mph->block[MPH_HEADER_WORDS]);
+  mph->words = &(mph->level_offsets[mph->number_levels + ((size_t)1)]);
+  mph->ranks = (const uint32_t *)&(mph->words[mph->block[4]]);
+}
+
+mph_t *create_mph(const uint64_t *fingerprints, size_t n, double gamma) {
+  uint64_t *keys, *words, *collisions, *block;
+  uint64_t level_offsets[MPH_MAX_LEVELS + ((size_t)1)];
+  uint32_t *ranks;
+  size_t remaining, next, level, number_words, w, i, j, p, rank;
+  mph_t *mph;
+
+  if (!(gamma >= 1.0)) gamma = 1.0;
+
+  keys = (uint64_t *)malloc((n + ((size_t)1)) * sizeof(uint64_t));
+  if (keys == NULL) error_no_mem();
+  if (n > ((size_t)0)) memcpy(keys, fingerprints, n * sizeof(uint64_t));
+
+  words = NULL;
+  number_words = (size_t)0;
+  level_offsets[0] = (uint64_t)0;
+  remaining = n;
+  for (level = ((size_t)0); (remaining > ((size_t)0)) &&
+                            (level < MPH_MAX_LEVELS);
+       level++) {
+    w = (((size_t)(gamma * ((double)remaining))) + ((size_t)63)) >> 6;
+    words = (uint64_t *)realloc(words, (number_words + w) * sizeof(uint64_t));
+    collisions = (uint64_t *)calloc(w, sizeof(uint64_t));
+    if ((words == NULL) || (collisions == NULL)) error_no_mem();
+    memset(&(words[number_words]), 0, w * sizeof(uint64_t));
+
+    /* Keeps the bits set by exactly one key */
+    for (i = ((size_t)0); i < remaining; i++) {
+      p = __mph_position(keys[i], level, w << 6);
+      if (__test_mph_bit(&(words[number_words]), p)) {
+        __set_mph_bit(collisions, p);
+      } else {
+        __set_mph_bit(&(words[number_words]), p);
+      }
+    }
+    for (j = ((size_t)0); j < w; j++) {
+      words[number_words + j] &= ~collisions[j];
+    }
+
+    next = (size_t)0;
+    for (i = ((size_t)0); i < remaining; i++) {
+      p = __mph_position(keys[i], level, w << 6);
+      if (!__test_mph_bit(&(words[number_words]), p)) keys[next++] = keys[i];
+    }
+
+    free(collisions);
+    remaining = next;
+    number_words += w;
+    level_offsets[level + ((size_t)1)] = (uint64_t)number_words;
+  }
+  free(keys);
+
+  /* Only equal fingerprints keep colliding level after level */
+  if (remaining > ((size_t)0)) {
+    free(words);
+    return NULL;
+  }
+
+  mph = (mph_t *)calloc(1, sizeof(mph_t));
+  if (mph == NULL) error_no_mem();
+  mph->len = __mph_block_words(level, number_words) * sizeof(uint64_t);
+  block = (uint64_t *)calloc(1, mph->len);
+  if (block == NULL) error_no_mem();
+
+  block[0] = MPH_MAGIC;
+  block[1] = (uint64_t)get_hash_family();
+  block[2] = (uint64_t)n;
+  block[3] = (uint64_t)level;
+  block[4] = (uint64_t)number_words;
+  memcpy(&(block[MPH_HEADER_WORDS]), level_offsets,
+         (level + ((size_t)1)) * sizeof(uint64_t));
+  if (number_words > ((size_t)0)) {
+    memcpy(&(block[MPH_HEADER_WORDS + level + ((size_t)1)]), words,
+           number_words * sizeof(uint64_t));
+  }
+  free(words);
+
+  mph->block = block;
+  mph->owned = 1;
+  __map_mph_block(mph);
+
+  ranks = (uint32_t *)mph->ranks;
+  rank = (size_t)0;
+  for (i = ((size_t)0); i < number_words; i++) {
+    if ((i % MPH_RANK_WORDS) == ((size_t)0)) {
+      ranks[i / MPH_RANK_WORDS] = (uint32_t)rank;
+    }
+    rank += __popcount64(mph->words[i]);
+  }
+
+  return mph;
+}
+
+mph_t *open_mph(const void *block, size_t len) {
+  const uint64_t *words = block;
+  size_t i, number_levels, number_words;
+  mph_t *mph;
+
+  if ((len < (MPH_HEADER_WORDS * sizeof(uint64_t))) ||
+      ((len % sizeof(uint64_t)) != ((size_t)0)) ||
+      ((((uintptr_t)block) % ((uintptr_t)sizeof(uint64_t))) !=
+       ((uintptr_t)0))) {
+    return NULL;
+  }
+  if ((words[0] != MPH_MAGIC) ||
+      (words[1] != (uint64_t)get_hash_family()) ||
+      (words[3] > (uint64_t)MPH_MAX_LEVELS) ||
+      (words[4] >= (uint64_t)(len / sizeof(uint64_t)))) {
+    return NULL;
+  }
+  number_levels = (size_t)words[3];
+  number_words = (size_t)words[4];
+  if ((__mph_block_words(number_levels, number_words) * sizeof(uint64_t)) !=
+      len) {
+    return NULL;
+  }
+  if (words[2] > ((uint64_t)number_words) * ((uint64_t)64)) return NULL;
+
+  /* Every level holds at least one word */
+  if (words[MPH_HEADER_WORDS] != (uint64_t)0) return NULL;
+  for (i = ((size_t)0); i < number_levels; i++) {
+    if (words[MPH_HEADER_WORDS + i] >= words[MPH_HEADER_WORDS + i + 1]) {
+      return NULL;
+    }
+  }
+  if (words[MPH_HEADER_WORDS + number_levels] != (uint64_t)number_words) {
+    return NULL;
+  }
+
+  mph = (mph_t *)calloc(1, sizeof(mph_t));
+  if (mph == NULL) error_no_mem();
+  mph->block = words;
+  mph->len = len;
+  mph->owned = 0;
+  __map_mph_block(mph);
+
+  return mph;
+}
+
+void delete_mph(mph_t *mph) {
+  if (mph->owned) free((void *)mph->block);
+  free(mph);
+}
+
+size_t lookup_in_mph(mph_t *mph, uint64_t fingerprint) {
+  size_t level, offset, w, i, j, rank;
+
+  for (level = ((size_t)0); level < mph->number_levels; level++) {
+    offset = (size_t)mph->level_offsets[level];
+    w = ((size_t)mph->level_offsets[level + ((size_t)1)]) - offset;
+    i = (offset << 6) + __mph_position(fingerprint, level, w << 6);
+    if (__test_mph_bit(mph->words, i)) {
+      rank = (size_t)mph->ranks[(i >> 6) / MPH_RANK_WORDS];
+      for (j = ((i >> 6) / MPH_RANK_WORDS) * MPH_RANK_WORDS; j < (i >> 6);
+           j++) {
+        rank += __popcount64(mph->words[j]);
+      }
+      rank += __popcount64(mph->words[i >> 6] &
+                           ((((uint64_t)1) << (i & ((size_t)63))) -
+                            ((uint64_t)1)));
+      return rank;
+    }
+  }
+
+  return MPH_NOT_FOUND;
+}
+
+size_t number_keys_in_mph(mph_t *mph) { return mph->number_keys; }
+
+const void *get_mph_block(mph_t *mph, size_t *len) {
+  *len = mph->len;
+
+  return mph->block;
+}
@@ -0,0 +1,92 @@
+#ifndef __MPH_H__
+#define __MPH_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* A minimal perfect hash function maps each of the n keys it
+   has been built over to its own index in 0, ..., n - 1, in a
+   single probe of a table of n entries.
+
+   The keys are given by 64-bit fingerprints, e.g. computed
+   with hash_mem64, which must all be different. The function
+   is built level by level, BBHash-style: each level is a bit
+   array of about gamma bits per key left, in which every key
+   sets the bit hash_uint64 gives for its fingerprint and the
+   level. The keys whose bit no other key has set are placed
+   there, the others go on to the next level. The index of a
+   key is the number of set bits before its own, counted with
+   a rank table of one 32-bit count every 512 bits.
+
+   With gamma = 1, the function takes about 3 bits per key.
+   It is stored in one flat block of 64-bit words without any
+   pointer, so that it can be written into a file and used in
+   place once the file is mapped.
+*/
+typedef struct __mph_struct_t mph_t;
+
+/* The smallest and densest gamma. Larger values build faster
+   and look up faster at the cost of more bits per key.
+*/
+#define MPH_DEFAULT_GAMMA (1.0)
+
+/* Returned by lookup_in_mph for some of the fingerprints the
+   function has not been built over
+*/
+#define MPH_NOT_FOUND SIZE_MAX
+
+/* Builds a minimal perfect hash function over the n
+   fingerprints in argument, with gamma bits per key and
+   level. gamma is taken to be 1 if it is smaller.
+
+   O(n) expected
+
+   Returns NULL if two of the fingerprints are equal, which
+   no function can tell apart.
+*/
+mph_t *create_mph(const uint64_t *fingerprints, size_t n, double gamma);
+
+/* Opens the flat block of a minimal perfect hash function in
+   place, without copying it. The block must stay mapped and
+   unchanged until the function is deleted.
+
+   O(1)
+
+   Returns NULL if the block is not well formed or has been
+   built with another hash family than the current one. The
+   set bits are not checked: lookups in a corrupted block may
+   return any index, as for fingerprints the function has not
+   been built over.
+*/
+mph_t *open_mph(const void *block, size_t len);
+
+/* Deletes a minimal perfect hash function, and its flat block
+   unless it has been opened in place
+
+   O(1)
+*/
+void delete_mph(mph_t *mph);
+
+/* Returns the index of a fingerprint the function has been
+   built over. Returns an arbitrary index or MPH_NOT_FOUND
+   for any other fingerprint, so the caller must check the
+   key found at that index.
+
+   O(1)
+*/
+size_t lookup_in_mph(mph_t *mph, uint64_t fingerprint);
+
+/* Returns the number of keys the function has been built over
+
+   O(1)
+*/
+size_t number_keys_in_mph(mph_t *mph);
+
+/* Returns the flat block of the function and stores its
+   length in bytes, a multiple of 8, in len
+
+   O(1)
+*/
+const void *get_mph_block(mph_t *mph, size_t *len);
+
+#endif
@@ -0,0 +1,233 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "oahashtable.h"
+
+/* A slot is empty iff dist is zero. Otherwise, dist - 1 is the
+   number of slots the entry sits past the slot its hash maps to.
+*/
+struct __oa_hashtable_slot_struct_t {
+  uint32_t hash;
+  uint32_t dist;
+  void *key;
+  void *value;
+};
+
+#define MIN_SLOTS ((size_t)8)
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+/* Returns the number of slots needed to hold n entries at a
+   load factor of at most 7/8. Always a power of 2.
+*/
+static size_t __oa_hashtable_slots_for(size_t n) {
+  size_t s;
+
+  s = MIN_SLOTS;
+  while ((s - (s >> 3)) < n) s <<= 1;
+
+  return s;
+}
+
+static oa_hashtable_slot_t *__alloc_oa_hashtable_slots(size_t n) {
+  oa_hashtable_slot_t *slots;
+
+  slots = (oa_hashtable_slot_t *)calloc(n, sizeof(oa_hashtable_slot_t));
+  if (slots == NULL) error_no_mem();
+
+  return slots;
+}
+
+oa_hashtable_t *create_oa_hashtable(size_t const size) {
+  oa_hashtable_t *hashtable;
+
+  hashtable = (oa_hashtable_t *)calloc(1, sizeof(oa_hashtable_t));
+  if (hashtable == NULL) error_no_mem();
+
+  hashtable->size = __oa_hashtable_slots_for(size);
+  hashtable->number_entries = (size_t)0;
+  hashtable->slots = __alloc_oa_hashtable_slots(hashtable->size);
+
+  return hashtable;
+}
+
+void delete_oa_hashtable(oa_hashtable_t *hashtable,
+                         void (*delete_key)(void *, void *),
+                         void (*delete_value)(void *, void *), void *data) {
+  size_t i;
+
+  for (i = ((size_t)0); i < hashtable->size; ++i) {
+    if (hashtable->slots[i].dist != ((uint32_t)0)) {
+      delete_key(hashtable->slots[i].key, data);
+      delete_value(hashtable->slots[i].value, data);
+    }
+  }
+
+  free(hashtable->slots);
+  free(hashtable);
+}
+
+void *lookup_in_oa_hashtable(oa_hashtable_t *hashtable, void *key,
+                             uint32_t (*hash_key)(void *, void *),
+                             int (*compare_keys)(void *, void *, void *),
+                             void *data) {
+  uint32_t hash, dist;
+  size_t mask, idx;
+  oa_hashtable_slot_t *slot;
+
+  hash = hash_key(key, data);
+  mask = hashtable->size - ((size_t)1);
+  idx = ((size_t)hash) & mask;
+
+  /* Robin Hood keeps every cluster sorted by home slot, so the
+     sought key cannot sit past a slot that is closer to its
+     own home than we are to ours.
+  */
+  for (dist = ((uint32_t)1);; ++dist, idx = (idx + ((size_t)1)) & mask) {
+    slot = &(hashtable->slots[idx]);
+    if (slot->dist < dist) return NULL;
+    if ((slot->hash == hash) && (compare_keys(key, slot->key, data) == 0)) {
+      return slot->value;
+    }
+  }
+}
+
+/* Places a slot into the slot array without growing it and
+   without looking at the keys. An entry is placed in front of
+   the entries with the same home slot, so that the entry added
+   last is found first.
+*/
+static void __place_oa_hashtable_slot(oa_hashtable_slot_t *slots, size_t size,
+                                      oa_hashtable_slot_t placed) {
+  size_t mask, idx;
+  oa_hashtable_slot_t t;
+
+  mask = size - ((size_t)1);
+  idx = ((size_t)placed.hash) & mask;
+  placed.dist = (uint32_t)1;
+
+  for (;; idx = (idx + ((size_t)1)) & mask) {
+    if (slots[idx].dist == ((uint32_t)0)) {
+      slots[idx] = placed;
+      return;
+    }
+    if (slots[idx].dist <= placed.dist) {
+      t = slots[idx];
+      slots[idx] = placed;
+      placed = t;
+    }
+    placed.dist++;
+  }
+}
+
+/* Entries with the same home slot in the new table have the
+   same home slot in the old one, and sit in the same cluster,
+   the entry added last first. Each cluster is re-placed from its
+   last slot to its first, so that the entries added last are
+   placed last and end up first again. The scan starts after an
+   empty slot, so that no cluster wraps around it.
+*/
+static void __resize_oa_hashtable(oa_hashtable_t *hashtable,
+                                 size_t new_size) {
+  size_t i, j, k, empty, mask, count;
+  oa_hashtable_slot_t *new_slots;
+
+  new_slots = __alloc_oa_hashtable_slots(new_size);
+
+  /* The load factor leaves at least one slot empty */
+  mask = hashtable->size - ((size_t)1);
+  empty = (size_t)0;
+  while (hashtable->slots[empty].dist != ((uint32_t)0)) empty++;
+
+  count = (size_t)0;
+  for (k = ((size_t)1); k <= hashtable->size; ++k) {
+    i = (empty + k) & mask;
+    if (hashtable->slots[i].dist != ((uint32_t)0)) {
+      count++;
+      continue;
+    }
+    for (j = ((size_t)1); j <= count; ++j) {
+      __place_oa_hashtable_slot(new_slots, new_size,
+                                hashtable->slots[(i - j) & mask]);
+    }
+    count = (size_t)0;
+  }
+
+  free(hashtable->slots);
+  hashtable->slots = new_slots;
+  hashtable->size = new_size;
+}
+
+void reserve_oa_hashtable(oa_hashtable_t *hashtable, size_t number_entries) {
+  size_t new_size;
+
+  new_size = __oa_hashtable_slots_for(number_entries);
+  if (new_size > hashtable->size) __resize_oa_hashtable(hashtable, new_size);
+}
+
+void add_hashed_to_oa_hashtable(oa_hashtable_t *hashtable, void *key,
+                                void *value, uint32_t hash,
+                                void *(*copy_key)(void *, void *),
+                                void *(*copy_value)(void *, void *),
+                                void *data) {
+  oa_hashtable_slot_t added_slot;
+
+  if ((hashtable->number_entries + ((size_t)1)) >
+      (hashtable->size - (hashtable->size >> 3))) {
+    __resize_oa_hashtable(hashtable, hashtable->size << 1);
+  }
+
+  added_slot.hash = hash;
+  added_slot.dist = (uint32_t)0;
+  added_slot.key = copy_key(key, data);
+  added_slot.value = copy_value(value, data);
+
+  __place_oa_hashtable_slot(hashtable->slots, hashtable->size, added_slot);
+  hashtable->number_entries++;
+}
+
+void add_to_oa_hashtable(oa_hashtable_t *hashtable, void *key, void *value,
+                         void *(*copy_key)(void *, void *),
+                         void *(*copy_value)(void *, void *),
+                         uint32_t (*hash_key)(void *, void *), void *data) {
+  add_hashed_to_oa_hashtable(hashtable, key, value, hash_key(key, data),
+                             copy_key, copy_value, data);
+}
+
+void iterate_over_oa_hashtable(oa_hashtable_t *hashtable,
+                               void (*f)(void *, void *, void *), void *data) {
+  size_t i;
+
+  for (i = ((size_t)0); i < hashtable->size; ++i) {
+    if (hashtable->slots[i].dist != ((uint32_t)0)) {
+      f(hashtable->slots[i].key, hashtable->slots[i].value, data);
+    }
+  }
+}
+
+size_t number_entries_in_oa_hashtable(oa_hashtable_t *hashtable) {
+  return hashtable->number_entries;
+}
+
+size_t max_number_collisions_in_oa_hashtable(oa_hashtable_t *hashtable) {
+  size_t i, k;
+
+  k = (size_t)0;
+  for (i = ((size_t)0); i < hashtable->size; ++i) {
+    if (((size_t)hashtable->slots[i].dist) > k) {
+      k = (size_t)hashtable->slots[i].dist;
+    }
+  }
+
+  if (k == ((size_t)0)) return 0;
+
+  return k - ((size_t)1);
+}
+
+size_t number_empty_entries_in_oa_hashtable(oa_hashtable_t *hashtable) {
+  return hashtable->size - hashtable->number_entries;
+}
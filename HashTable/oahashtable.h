@@ -0,0 +1,141 @@
+#ifndef __OA_HASHTABLE_H__
+#define __OA_HASHTABLE_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct __oa_hashtable_slot_struct_t oa_hashtable_slot_t;
+
+typedef struct __oa_hashtable_struct_t {
+  size_t size;
+  size_t number_entries;
+  oa_hashtable_slot_t *slots;
+} oa_hashtable_t;
+
+/* Create an open addressing hashtable able to hold the
+   number of entries given in argument before it has to grow.
+
+   O(n)
+
+   The slots are kept in one flat array, probed linearly
+   with the Robin Hood discipline. Each slot caches the
+   32-bit hash of its key next to the key and value pointers.
+   The table doubles its number of slots when more than 7/8
+   of them are in use.
+
+   Creates a hashtable able to hold one entry, if the size
+   in argument is zero.
+*/
+oa_hashtable_t *create_oa_hashtable(const size_t);
+
+/* Delete an open addressing hashtable. Calls delete_key for
+   each key and calls delete_value for each value.
+
+   O(n)
+
+   The data pointer is given back to the delete_key
+   and delete_value functions as their last argument.
+*/
+void delete_oa_hashtable(oa_hashtable_t *hashtable,
+                         void (*delete_key)(void *, void *),
+                         void (*delete_value)(void *, void *), void *data);
+
+/* Lookup a key in an open addressing hashtable. Calls hash_key
+   to compute the hash. Calls compare_keys to compare the keys
+   of the probed slots whose cached hash equals the hash of the
+   given key.
+
+   O(1) expected, O(n) if the probe sequence is long.
+
+   Returns a pointer to the value. The value is
+   the copy held in the hashtable. No copy is made.
+
+   If the key is not found, returns NULL.
+
+   If the same key has been added several times, the value
+   added last is returned.
+
+   The data pointer is given back to the hash_key
+   and compare_keys functions as their last argument.
+*/
+void *lookup_in_oa_hashtable(oa_hashtable_t *hashtable, void *key,
+                             uint32_t (*hash_key)(void *, void *),
+                             int (*compare_keys)(void *, void *, void *),
+                             void *data);
+
+/* Add a key->value pair to an open addressing hashtable. Calls
+   copy_key to copy the key. Calls copy_value to copy the
+   value. Calls hash_key to compute the hash of the key.
+
+   O(1) amortized. Growing the table reuses the cached
+   hashes and never calls hash_key.
+
+   The data pointer is given back to the copy_key, copy_value
+   and hash_key functions as their last argument.
+*/
+void add_to_oa_hashtable(oa_hashtable_t *hashtable, void *key, void *value,
+                         void *(*copy_key)(void *, void *),
+                         void *(*copy_value)(void *, void *),
+                         uint32_t (*hash_key)(void *, void *), void *data);
+
+/* Add a key->value pair whose hash has already been computed,
+   e.g. with hash_mem_batch, to an open addressing hashtable.
+   Same as add_to_oa_hashtable without the call to hash_key.
+
+   O(1) amortized.
+
+   The data pointer is given back to the copy_key and
+   copy_value functions as their last argument.
+*/
+void add_hashed_to_oa_hashtable(oa_hashtable_t *hashtable, void *key,
+                                void *value, uint32_t hash,
+                                void *(*copy_key)(void *, void *),
+                                void *(*copy_value)(void *, void *),
+                                void *data);
+
+/* Grow an open addressing hashtable at once so that it can
+   hold the number of entries given in argument without
+   growing again.
+
+   O(n)
+*/
+void reserve_oa_hashtable(oa_hashtable_t *hashtable, size_t number_entries);
+
+/* Calls f on every key->value pair held in the open
+   addressing hashtable, in slot order. The hashtable must not
+   be modified by f.
+
+   O(n)
+
+   The data pointer is given back to f as its last argument.
+*/
+void iterate_over_oa_hashtable(oa_hashtable_t *hashtable,
+                               void (*f)(void *, void *, void *), void *data);
+
+/* Returns the number of entries in the open addressing hashtable
+
+   O(1)
+*/
+size_t number_entries_in_oa_hashtable(oa_hashtable_t *hashtable);
+
+/* Returns the maximum number of collisions in the open
+   addressing hashtable
+
+   If the hashtable has no entries, returns 0.
+
+   If the hashtable does have entries, returns the largest
+   number of slots an entry sits past the slot its hash
+   maps to.
+
+   O(n)
+*/
+size_t max_number_collisions_in_oa_hashtable(oa_hashtable_t *hashtable);
+
+/* Returns the number of slots that are empty in the open
+   addressing hashtable.
+
+   O(1)
+*/
+size_t number_empty_entries_in_oa_hashtable(oa_hashtable_t *hashtable);
+
+#endif
@@ -0,0 +1,419 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "epoch.h"
+#include "rcuhashtable.h"
+
+/* The fields of a node other than next never change once the
+   node has been published
+*/
+typedef struct __rcu_hashtable_node_struct_t {
+  _Atomic(struct __rcu_hashtable_node_struct_t *) next;
+  uint32_t hash;
+  void *key;
+  void *value;
+} __rcu_hashtable_node_t;
+
+typedef struct {
+  size_t size;
+  _Atomic(__rcu_hashtable_node_t *) *buckets;
+} __rcu_hashtable_table_t;
+
+struct __rcu_hashtable_struct_t {
+  _Atomic(__rcu_hashtable_table_t *) table;
+  _Atomic size_t number_entries;
+  pthread_mutex_t writer_lock;
+  epoch_domain_t *domain;
+};
+
+/* What is left to delete of a removed entry or of a replaced
+   value once no reader can see it any longer. delete_key is
+   NULL when the key lives on in another node.
+*/
+typedef struct {
+  __rcu_hashtable_node_t *node;
+  void (*delete_key)(void *, void *);
+  void (*delete_value)(void *, void *);
+  void *data;
+} __rcu_hashtable_garbage_t;
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+static __rcu_hashtable_table_t *__alloc_rcu_hashtable_table(size_t size) {
+  __rcu_hashtable_table_t *table;
+  size_t i;
+
+  table = (__rcu_hashtable_table_t *)calloc(1, sizeof(__rcu_hashtable_table_t));
+  if (table == NULL) error_no_mem();
+  table->buckets = calloc(size, sizeof(*(table->buckets)));
+  if (table->buckets == NULL) error_no_mem();
+
+  table->size = size;
+  for (i = ((size_t)0); i < size; ++i) {
+    atomic_init(&(table->buckets[i]), NULL);
+  }
+
+  return table;
+}
+
+static __rcu_hashtable_node_t *__alloc_rcu_hashtable_node(uint32_t hash,
+                                                          void *key,
+                                                          void *value) {
+  __rcu_hashtable_node_t *node;
+
+  node = (__rcu_hashtable_node_t *)calloc(1, sizeof(__rcu_hashtable_node_t));
+  if (node == NULL) error_no_mem();
+
+  atomic_init(&(node->next), NULL);
+  node->hash = hash;
+  node->key = key;
+  node->value = value;
+
+  return node;
+}
+
+/* Frees the nodes and the bucket array of a table, but not the
+   keys and values, which live on in the newer table
+*/
+static void __delete_rcu_hashtable_table(void *ptr, void *data) {
+  __rcu_hashtable_table_t *table = ptr;
+  __rcu_hashtable_node_t *curr, *next;
+  size_t i;
+
+  for (i = ((size_t)0); i < table->size; ++i) {
+    for (curr = atomic_load_explicit(&(table->buckets[i]),
+                                     memory_order_relaxed);
+         curr != NULL; curr = next) {
+      next = atomic_load_explicit(&(curr->next), memory_order_relaxed);
+      free(curr);
+    }
+  }
+
+  free(table->buckets);
+  free(table);
+}
+
+static void __delete_rcu_hashtable_garbage(void *ptr, void *data) {
+  __rcu_hashtable_garbage_t *garbage = ptr;
+
+  if (garbage->delete_key != NULL) {
+    garbage->delete_key(garbage->node->key, garbage->data);
+  }
+  garbage->delete_value(garbage->node->value, garbage->data);
+  free(garbage->node);
+  free(garbage);
+}
+
+static void __retire_rcu_hashtable_node(rcu_hashtable_t *hashtable,
+                                        __rcu_hashtable_node_t *node,
+                                        void (*delete_key)(void *, void *),
+                                        void (*delete_value)(void *, void *),
+                                        void *data) {
+  __rcu_hashtable_garbage_t *garbage;
+
+  garbage =
+      (__rcu_hashtable_garbage_t *)calloc(1, sizeof(__rcu_hashtable_garbage_t));
+  if (garbage == NULL) error_no_mem();
+
+  garbage->node = node;
+  garbage->delete_key = delete_key;
+  garbage->delete_value = delete_value;
+  garbage->data = data;
+
+  retire_in_epoch(hashtable->domain, garbage, __delete_rcu_hashtable_garbage,
+                  NULL);
+}
+
+rcu_hashtable_t *create_rcu_hashtable(size_t size) {
+  rcu_hashtable_t *hashtable;
+
+  if (size < ((size_t)1)) size = (size_t)1;
+
+  hashtable = (rcu_hashtable_t *)calloc(1, sizeof(rcu_hashtable_t));
+  if (hashtable == NULL) error_no_mem();
+
+  atomic_init(&(hashtable->table), __alloc_rcu_hashtable_table(size));
+  atomic_init(&(hashtable->number_entries), (size_t)0);
+  if (pthread_mutex_init(&(hashtable->writer_lock), NULL) != 0) {
+    error_no_mem();
+  }
+  hashtable->domain = create_epoch_domain();
+
+  return hashtable;
+}
+
+void delete_rcu_hashtable(rcu_hashtable_t *hashtable,
+                          void (*delete_key)(void *, void *),
+                          void (*delete_value)(void *, void *), void *data) {
+  __rcu_hashtable_table_t *table;
+  __rcu_hashtable_node_t *curr;
+  size_t i;
+
+  table = atomic_load_explicit(&(hashtable->table), memory_order_relaxed);
+  for (i = ((size_t)0); i < table->size; ++i) {
+    for (curr = atomic_load_explicit(&(table->buckets[i]),
+                                     memory_order_relaxed);
+         curr != NULL;
+         curr = atomic_load_explicit(&(curr->next), memory_order_relaxed)) {
+      delete_key(curr->key, data);
+      delete_value(curr->value, data);
+    }
+  }
+  __delete_rcu_hashtable_table(table, NULL);
+
+  delete_epoch_domain(hashtable->domain);
+  pthread_mutex_destroy(&(hashtable->writer_lock));
+  free(hashtable);
+}
+
+epoch_reader_t *register_rcu_hashtable_reader(rcu_hashtable_t *hashtable) {
+  return register_epoch_reader(hashtable->domain);
+}
+
+void unregister_rcu_hashtable_reader(rcu_hashtable_t *hashtable,
+                                     epoch_reader_t *reader) {
+  unregister_epoch_reader(hashtable->domain, reader);
+}
+
+void *lookup_in_rcu_hashtable(rcu_hashtable_t *hashtable, void *key,
+                              uint32_t (*hash_key)(void *, void *),
+                              int (*compare_keys)(void *, void *, void *),
+                              void *data) {
+  uint32_t hash;
+  __rcu_hashtable_table_t *table;
+  __rcu_hashtable_node_t *curr;
+
+  hash = hash_key(key, data);
+  table = atomic_load_explicit(&(hashtable->table), memory_order_acquire);
+
+  for (curr = atomic_load_explicit(
+           &(table->buckets[((size_t)hash) % table->size]),
+           memory_order_acquire);
+       curr != NULL;
+       curr = atomic_load_explicit(&(curr->next), memory_order_acquire)) {
+    if ((curr->hash == hash) && (compare_keys(key, curr->key, data) == 0)) {
+      return curr->value;
+    }
+  }
+
+  return NULL;
+}
+
+/* Copies all nodes into a new table of new_size buckets,
+   keeping the order of the nodes with equal keys, publishes it
+   and retires the old one. Called with the writer lock held.
+*/
+static __rcu_hashtable_table_t *__resize_rcu_hashtable(
+    rcu_hashtable_t *hashtable, size_t new_size) {
+  __rcu_hashtable_table_t *table, *new_table;
+  __rcu_hashtable_node_t **tails;
+  __rcu_hashtable_node_t *curr, *node;
+  size_t i, idx;
+
+  table = atomic_load_explicit(&(hashtable->table), memory_order_relaxed);
+  new_table = __alloc_rcu_hashtable_table(new_size);
+  tails = (__rcu_hashtable_node_t **)calloc(new_size, sizeof(*tails));
+  if (tails == NULL) error_no_mem();
+
+  for (i = ((size_t)0); i < table->size; ++i) {
+    for (curr = atomic_load_explicit(&(table->buckets[i]),
+                                     memory_order_relaxed);
+         curr != NULL;
+         curr = atomic_load_explicit(&(curr->next), memory_order_relaxed)) {
+      node = __alloc_rcu_hashtable_node(curr->hash, curr->key, curr->value);
+      idx = ((size_t)curr->hash) % new_size;
+      if (tails[idx] == NULL) {
+        atomic_store_explicit(&(new_table->buckets[idx]), node,
+                              memory_order_relaxed);
+      } else {
+        atomic_store_explicit(&(tails[idx]->next), node, memory_order_relaxed);
+      }
+      tails[idx] = node;
+    }
+  }
+  free(tails);
+
+  atomic_store_explicit(&(hashtable->table), new_table, memory_order_release);
+  retire_in_epoch(hashtable->domain, table, __delete_rcu_hashtable_table,
+                  NULL);
+
+  return new_table;
+}
+
+/* Called with the writer lock held */
+static void __add_hashed_to_rcu_hashtable(rcu_hashtable_t *hashtable,
+                                          void *key, void *value,
+                                          uint32_t hash,
+                                          void *(*copy_key)(void *, void *),
+                                          void *(*copy_value)(void *, void *),
+                                          void *data) {
+  __rcu_hashtable_table_t *table;
+  __rcu_hashtable_node_t *node;
+  _Atomic(__rcu_hashtable_node_t *) *bucket;
+  size_t n;
+
+  table = atomic_load_explicit(&(hashtable->table), memory_order_relaxed);
+  n = atomic_load_explicit(&(hashtable->number_entries), memory_order_relaxed);
+  if ((n + ((size_t)1)) > table->size) {
+    table = __resize_rcu_hashtable(hashtable, table->size << 1);
+  }
+
+  node = __alloc_rcu_hashtable_node(hash, copy_key(key, data),
+                                    copy_value(value, data));
+  bucket = &(table->buckets[((size_t)hash) % table->size]);
+  atomic_store_explicit(&(node->next),
+                        atomic_load_explicit(bucket, memory_order_relaxed),
+                        memory_order_relaxed);
+  atomic_store_explicit(bucket, node, memory_order_release);
+
+  atomic_store_explicit(&(hashtable->number_entries), n + ((size_t)1),
+                        memory_order_relaxed);
+}
+
+void add_to_rcu_hashtable(rcu_hashtable_t *hashtable, void *key, void *value,
+                          void *(*copy_key)(void *, void *),
+                          void *(*copy_value)(void *, void *),
+                          uint32_t (*hash_key)(void *, void *), void *data) {
+  uint32_t hash;
+
+  pthread_mutex_lock(&(hashtable->writer_lock));
+  hash = hash_key(key, data);
+  __add_hashed_to_rcu_hashtable(hashtable, key, value, hash, copy_key,
+                                copy_value, data);
+  pthread_mutex_unlock(&(hashtable->writer_lock));
+
+  reclaim_epoch(hashtable->domain);
+}
+
+/* Returns the link, bucket head or next field of the previous
+   node, that points to the node added last with the given key,
+   or NULL if there is none. Called with the writer lock held.
+*/
+static _Atomic(__rcu_hashtable_node_t *) *__find_rcu_hashtable_link(
+    rcu_hashtable_t *hashtable, void *key, uint32_t hash,
+    int (*compare_keys)(void *, void *, void *), void *data) {
+  __rcu_hashtable_table_t *table;
+  _Atomic(__rcu_hashtable_node_t *) *link;
+  __rcu_hashtable_node_t *curr;
+
+  table = atomic_load_explicit(&(hashtable->table), memory_order_relaxed);
+  for (link = &(table->buckets[((size_t)hash) % table->size]);
+       (curr = atomic_load_explicit(link, memory_order_relaxed)) != NULL;
+       link = &(curr->next)) {
+    if ((curr->hash == hash) && (compare_keys(key, curr->key, data) == 0)) {
+      return link;
+    }
+  }
+
+  return NULL;
+}
+
+/* A reader standing on the unlinked node still finds the rest
+   of the chain through its next field, which is left as is
+*/
+void remove_from_rcu_hashtable(rcu_hashtable_t *hashtable, void *key,
+                               uint32_t (*hash_key)(void *, void *),
+                               int (*compare_keys)(void *, void *, void *),
+                               void (*delete_key)(void *, void *),
+                               void (*delete_value)(void *, void *),
+                               void *data) {
+  _Atomic(__rcu_hashtable_node_t *) *link;
+  __rcu_hashtable_node_t *node;
+
+  pthread_mutex_lock(&(hashtable->writer_lock));
+  link = __find_rcu_hashtable_link(hashtable, key, hash_key(key, data),
+                                   compare_keys, data);
+  if (link != NULL) {
+    node = atomic_load_explicit(link, memory_order_relaxed);
+    atomic_store_explicit(
+        link, atomic_load_explicit(&(node->next), memory_order_relaxed),
+        memory_order_release);
+    atomic_store_explicit(
+        &(hashtable->number_entries),
+        atomic_load_explicit(&(hashtable->number_entries),
+                             memory_order_relaxed) -
+            ((size_t)1),
+        memory_order_relaxed);
+    __retire_rcu_hashtable_node(hashtable, node, delete_key, delete_value,
+                                data);
+  }
+  pthread_mutex_unlock(&(hashtable->writer_lock));
+
+  reclaim_epoch(hashtable->domain);
+}
+
+/* The old node is swapped for a new node with the same key and
+   next field, so that the chain is never without the key
+*/
+void replace_in_rcu_hashtable(rcu_hashtable_t *hashtable, void *key,
+                              void *value, void *(*copy_key)(void *, void *),
+                              void *(*copy_value)(void *, void *),
+                              uint32_t (*hash_key)(void *, void *),
+                              int (*compare_keys)(void *, void *, void *),
+                              void (*delete_value)(void *, void *),
+                              void *data) {
+  uint32_t hash;
+  _Atomic(__rcu_hashtable_node_t *) *link;
+  __rcu_hashtable_node_t *node, *new_node;
+
+  pthread_mutex_lock(&(hashtable->writer_lock));
+  hash = hash_key(key, data);
+  link = __find_rcu_hashtable_link(hashtable, key, hash, compare_keys, data);
+  if (link == NULL) {
+    __add_hashed_to_rcu_hashtable(hashtable, key, value, hash, copy_key,
+                                  copy_value, data);
+  } else {
+    node = atomic_load_explicit(link, memory_order_relaxed);
+    new_node = __alloc_rcu_hashtable_node(hash, node->key,
+                                          copy_value(value, data));
+    atomic_store_explicit(
+        &(new_node->next),
+        atomic_load_explicit(&(node->next), memory_order_relaxed),
+        memory_order_relaxed);
+    atomic_store_explicit(link, new_node, memory_order_release);
+    __retire_rcu_hashtable_node(hashtable, node, NULL, delete_value, data);
+  }
+  pthread_mutex_unlock(&(hashtable->writer_lock));
+
+  reclaim_epoch(hashtable->domain);
+}
+
+void synchronize_rcu_hashtable(rcu_hashtable_t *hashtable) {
+  synchronize_epoch(hashtable->domain);
+}
+
+size_t number_entries_in_rcu_hashtable(rcu_hashtable_t *hashtable) {
+  return atomic_load_explicit(&(hashtable->number_entries),
+                              memory_order_relaxed);
+}
+
+size_t max_number_collisions_in_rcu_hashtable(rcu_hashtable_t *hashtable) {
+  __rcu_hashtable_table_t *table;
+  __rcu_hashtable_node_t *curr;
+  size_t i, k, l;
+
+  pthread_mutex_lock(&(hashtable->writer_lock));
+  table = atomic_load_explicit(&(hashtable->table), memory_order_relaxed);
+  k = (size_t)0;
+  for (i = ((size_t)0); i < table->size; ++i) {
+    l = (size_t)0;
+    for (curr = atomic_load_explicit(&(table->buckets[i]),
+                                     memory_order_relaxed);
+         curr != NULL;
+         curr = atomic_load_explicit(&(curr->next), memory_order_relaxed)) {
+      l++;
+    }
+    if (l > k) k = l;
+  }
+  pthread_mutex_unlock(&(hashtable->writer_lock));
+
+  if (k == ((size_t)0)) return 0;
+
+  return k - ((size_t)1);
+}
@@ -0,0 +1,173 @@
+#ifndef __RCU_HASHTABLE_H__
+#define __RCU_HASHTABLE_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "epoch.h"
+
+/* A hashtable for many readers and rare writers. Readers take
+   no lock and write no shared memory: each reading thread
+   registers a reader and brackets its lookups with enter_epoch
+   and exit_epoch.
+
+   Writers are serialized by a mutex. They never modify memory
+   a reader might be traversing in place. A new entry is linked
+   in with one atomic pointer store, a removed or replaced entry
+   is unlinked with one atomic pointer store, and a resize builds
+   a whole new bucket array that is published with one atomic
+   pointer store. Unlinked entries, replaced values and old bucket
+   arrays are deleted through epoch-based reclamation once no
+   reader can still see them.
+*/
+typedef struct __rcu_hashtable_struct_t rcu_hashtable_t;
+
+/* Create a read-optimized hashtable of certain size given in
+   argument.
+
+   O(n)
+
+   Creates a hashtable of size 1, if the size in argument is
+   zero. The hashtable doubles its number of buckets when it
+   holds more entries than buckets.
+*/
+rcu_hashtable_t *create_rcu_hashtable(size_t size);
+
+/* Delete a read-optimized hashtable. Calls delete_key for each
+   key and calls delete_value for each value, and deletes the
+   memory still waiting for readers at once. No reader may be
+   registered any longer.
+
+   O(n)
+
+   The data pointer is given back to the delete_key
+   and delete_value functions as their last argument.
+*/
+void delete_rcu_hashtable(rcu_hashtable_t *hashtable,
+                          void (*delete_key)(void *, void *),
+                          void (*delete_value)(void *, void *), void *data);
+
+/* Register a reader with a read-optimized hashtable. Each
+   reading thread needs a reader of its own, with which it calls
+   enter_epoch before and exit_epoch after its lookups.
+
+   O(1)
+*/
+epoch_reader_t *register_rcu_hashtable_reader(rcu_hashtable_t *hashtable);
+
+/* Unregister a reader of a read-optimized hashtable
+
+   O(number of readers)
+*/
+void unregister_rcu_hashtable_reader(rcu_hashtable_t *hashtable,
+                                     epoch_reader_t *reader);
+
+/* Lookup a key in a read-optimized hashtable. Calls hash_key to
+   compute the hash. Calls compare_keys to compare the keys of
+   the entries with the same hash.
+
+   Must be called between enter_epoch and exit_epoch of a reader
+   of the hashtable. Takes no lock.
+
+   O(1) if no collision, O(n) if collisions.
+
+   Returns a pointer to the value, which stays valid until
+   exit_epoch even if the entry is removed or replaced in the
+   meantime. Returns NULL if the key is not found.
+
+   If the same key has been added several times, the value
+   added last is returned.
+
+   The data pointer is given back to the hash_key
+   and compare_keys functions as their last argument.
+*/
+void *lookup_in_rcu_hashtable(rcu_hashtable_t *hashtable, void *key,
+                              uint32_t (*hash_key)(void *, void *),
+                              int (*compare_keys)(void *, void *, void *),
+                              void *data);
+
+/* Add a key->value pair to a read-optimized hashtable. Calls
+   copy_key to copy the key. Calls copy_value to copy the
+   value. Calls hash_key to compute the hash of the key.
+
+   O(1) amortized. A resize copies the entries, not the keys
+   and values, into a new bucket array.
+
+   The data pointer is given back to the copy_key, copy_value
+   and hash_key functions as their last argument.
+*/
+void add_to_rcu_hashtable(rcu_hashtable_t *hashtable, void *key, void *value,
+                          void *(*copy_key)(void *, void *),
+                          void *(*copy_value)(void *, void *),
+                          uint32_t (*hash_key)(void *, void *), void *data);
+
+/* Remove a key from a read-optimized hashtable. Calls hash_key
+   to compute the hash and compare_keys to find the key.
+
+   If the same key has been added several times, only the
+   value added last is removed. Does nothing if the key is
+   not found.
+
+   O(1) if no collisions, O(n) if collisions.
+
+   delete_key and delete_value are called on the removed key
+   and value later, once no reader can still see them, by some
+   writer or by delete_rcu_hashtable. The data pointer, which
+   must stay valid until then, is given back to all functions
+   as their last argument.
+*/
+void remove_from_rcu_hashtable(rcu_hashtable_t *hashtable, void *key,
+                               uint32_t (*hash_key)(void *, void *),
+                               int (*compare_keys)(void *, void *, void *),
+                               void (*delete_key)(void *, void *),
+                               void (*delete_value)(void *, void *),
+                               void *data);
+
+/* Replace the value of a key in a read-optimized hashtable with
+   a copy of the value in argument, made with copy_value. Readers
+   find either the old or the new value, never neither. Adds the
+   key->value pair, copying the key with copy_key, if the key is
+   not found.
+
+   If the same key has been added several times, only the
+   value added last is replaced.
+
+   O(1) if no collisions, O(n) if collisions.
+
+   delete_value is called on the old value later, once no
+   reader can still see it. The data pointer, which must stay
+   valid until then, is given back to all functions as their
+   last argument.
+*/
+void replace_in_rcu_hashtable(rcu_hashtable_t *hashtable, void *key,
+                              void *value, void *(*copy_key)(void *, void *),
+                              void *(*copy_value)(void *, void *),
+                              uint32_t (*hash_key)(void *, void *),
+                              int (*compare_keys)(void *, void *, void *),
+                              void (*delete_value)(void *, void *),
+                              void *data);
+
+/* Delete all memory retired by the writers that no reader can
+   still see, waiting for the readers inside an epoch to leave
+   it. Writers reclaim what they can without waiting on every
+   update already.
+
+   Must not be called from inside an epoch.
+*/
+void synchronize_rcu_hashtable(rcu_hashtable_t *hashtable);
+
+/* Returns the number of entries in the read-optimized
+   hashtable
+
+   O(1)
+*/
+size_t number_entries_in_rcu_hashtable(rcu_hashtable_t *hashtable);
+
+/* Returns the maximum number of collisions in the
+   read-optimized hashtable. Waits for the writers.
+
+   O(n)
+*/
+size_t max_number_collisions_in_rcu_hashtable(rcu_hashtable_t *hashtable);
+
+#endif
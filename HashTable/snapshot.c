@@ -0,0 +1,516 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.h"
+#include "mph.h"
+#include "snapshot.h"
+
+#define SNAPSHOT_MAGIC "HTSNAP\r\n"
+#define SNAPSHOT_VERSION ((uint32_t)2)
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t hash_family;
+  uint64_t number_entries;
+  uint64_t number_buckets;
+  /* number_buckets + 1 entry indices: bucket i holds the
+     entries buckets[i], ..., buckets[i + 1] - 1
+  */
+  uint64_t buckets_offset;
+  uint64_t entries_offset;
+  /* Flat block of the minimal perfect hash function the entries
+     are indexed with, if mph_len is not zero. There is then a
+     single bucket.
+  */
+  uint64_t mph_offset;
+  uint64_t mph_len;
+  uint64_t data_offset;
+  uint64_t file_len;
+  /* Of the bytes header_len, ..., file_len - 1 */
+  uint64_t checksum;
+} __snapshot_header_t;
+
+/* hash is hash_mem64 of the key */
+typedef struct {
+  uint64_t key_offset;
+  uint64_t key_len;
+  uint64_t value_offset;
+  uint64_t value_len;
+  uint64_t hash;
+} __snapshot_entry_t;
+
+/* While writing, the offsets of the entries are relative
+   to the start of data
+*/
+struct __snapshot_writer_struct_t {
+  size_t number_entries;
+  size_t capacity;
+  __snapshot_entry_t *entries;
+  unsigned char *data;
+  size_t data_len;
+  size_t data_capacity;
+};
+
+struct __snapshot_struct_t {
+  const unsigned char *mapping;
+  size_t mapping_len;
+  const __snapshot_header_t *header;
+  const uint64_t *buckets;
+  const __snapshot_entry_t *entries;
+  size_t mask;
+  mph_t *mph;
+};
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+/* Fletcher-style checksum over 8-byte words, updated chunk by
+   chunk. All chunks but the last must have a length that is a
+   multiple of 8.
+*/
+static void __update_snapshot_checksum(uint64_t *a, uint64_t *b,
+                                       const void *ptr, size_t n) {
+  const unsigned char *p = ptr;
+  size_t i;
+  uint64_t w, sa, sb;
+
+  sa = *a;
+  sb = *b;
+  for (i = ((size_t)0); (i + ((size_t)8)) <= n; i += ((size_t)8)) {
+    memcpy(&w, &p[i], sizeof(w));
+    sa += w;
+    sb += sa;
+  }
+  if (i < n) {
+    w = (uint64_t)0;
+    memcpy(&w, &p[i], n - i);
+    sa += w;
+    sb += sa;
+  }
+  *a = sa;
+  *b = sb;
+}
+
+static uint64_t __finish_snapshot_checksum(uint64_t a, uint64_t b) {
+  return a ^ ((b << 32) | (b >> 32));
+}
+
+snapshot_writer_t *create_snapshot_writer(void) {
+  snapshot_writer_t *writer;
+
+  writer = (snapshot_writer_t *)calloc(1, sizeof(snapshot_writer_t));
+  if (writer == NULL) error_no_mem();
+
+  return writer;
+}
+
+void delete_snapshot_writer(snapshot_writer_t *writer) {
+  free(writer->entries);
+  free(writer->data);
+  free(writer);
+}
+
+static size_t __append_snapshot_data(snapshot_writer_t *writer,
+                                     const void *ptr, size_t n) {
+  size_t offset, capacity;
+  unsigned char *data;
+
+  if ((writer->data_len + n) > writer->data_capacity) {
+    capacity = ((writer->data_capacity == ((size_t)0))
+                    ? ((size_t)4096)
+                    : writer->data_capacity);
+    while ((writer->data_len + n) > capacity) capacity <<= 1;
+    data = (unsigned char *)realloc(writer->data, capacity);
+    if (data == NULL) error_no_mem();
+    writer->data = data;
+    writer->data_capacity = capacity;
+  }
+
+  offset = writer->data_len;
+  if (n > ((size_t)0)) memcpy(&(writer->data[offset]), ptr, n);
+  writer->data_len += n;
+
+  return offset;
+}
+
+void add_to_snapshot_writer(snapshot_writer_t *writer, const void *key,
+                            size_t key_len, const void *value,
+                            size_t value_len) {
+  size_t capacity;
+  __snapshot_entry_t *entries, *entry;
+
+  if (writer->number_entries >= writer->capacity) {
+    capacity = ((writer->capacity == ((size_t)0)) ? ((size_t)1024)
+                                                  : (writer->capacity << 1));
+    entries = (__snapshot_entry_t *)realloc(
+        writer->entries, capacity * sizeof(__snapshot_entry_t));
+    if (entries == NULL) error_no_mem();
+    writer->entries = entries;
+    writer->capacity = capacity;
+  }
+
+  entry = &(writer->entries[writer->number_entries]);
+  entry->hash = hash_mem64(key, key_len);
+  entry->key_len = (uint64_t)key_len;
+  entry->key_offset = (uint64_t)__append_snapshot_data(writer, key, key_len);
+  entry->value_len = (uint64_t)value_len;
+  entry->value_offset =
+      (uint64_t)__append_snapshot_data(writer, value, value_len);
+  writer->number_entries++;
+}
+
+int write_snapshot(snapshot_writer_t *writer, const char *filename) {
+  __snapshot_header_t header;
+  __snapshot_entry_t *entries;
+  uint64_t *buckets, *fingerprints;
+  size_t number_buckets, i, b, mph_len;
+  uint64_t a, s;
+  mph_t *mph;
+  const void *mph_block;
+  FILE *file;
+  int res;
+
+  fingerprints = (uint64_t *)calloc(writer->number_entries + ((size_t)1),
+                                    sizeof(uint64_t));
+  if (fingerprints == NULL) error_no_mem();
+  for (i = ((size_t)0); i < writer->number_entries; i++) {
+    fingerprints[i] = writer->entries[i].hash;
+  }
+  /* Fails on duplicate keys, which keep the bucket index so
+     that the value added first is found
+  */
+  mph = create_mph(fingerprints, writer->number_entries, MPH_DEFAULT_GAMMA);
+  free(fingerprints);
+  mph_block = NULL;
+  mph_len = (size_t)0;
+  if (mph != NULL) mph_block = get_mph_block(mph, &mph_len);
+
+  number_buckets = (size_t)1;
+  if (mph == NULL) {
+    while (number_buckets < writer->number_entries) number_buckets <<= 1;
+  }
+
+  buckets = (uint64_t *)calloc(number_buckets + ((size_t)1), sizeof(uint64_t));
+  entries = (__snapshot_entry_t *)calloc(writer->number_entries + ((size_t)1),
+                                         sizeof(__snapshot_entry_t));
+  if ((buckets == NULL) || (entries == NULL)) error_no_mem();
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.hash_family = (uint32_t)get_hash_family();
+  header.number_entries = (uint64_t)writer->number_entries;
+  header.number_buckets = (uint64_t)number_buckets;
+  header.buckets_offset = (uint64_t)sizeof(header);
+  header.entries_offset =
+      header.buckets_offset +
+      ((uint64_t)(number_buckets + ((size_t)1))) * sizeof(uint64_t);
+  header.mph_offset =
+      header.entries_offset +
+      ((uint64_t)writer->number_entries) * sizeof(__snapshot_entry_t);
+  header.mph_len = (uint64_t)mph_len;
+  header.data_offset = header.mph_offset + header.mph_len;
+  header.file_len = header.data_offset + (uint64_t)writer->data_len;
+
+  if (mph != NULL) {
+    /* Each entry goes to its index */
+    for (i = ((size_t)0); i < writer->number_entries; i++) {
+      b = lookup_in_mph(mph, writer->entries[i].hash);
+      entries[b] = writer->entries[i];
+      entries[b].key_offset += header.data_offset;
+      entries[b].value_offset += header.data_offset;
+    }
+    buckets[1] = (uint64_t)writer->number_entries;
+  } else {
+    /* Stable counting sort of the entries by bucket */
+    for (i = ((size_t)0); i < writer->number_entries; i++) {
+      b = ((size_t)writer->entries[i].hash) & (number_buckets - ((size_t)1));
+      buckets[b + ((size_t)1)]++;
+    }
+    for (b = ((size_t)0); b < number_buckets; b++) {
+      buckets[b + ((size_t)1)] += buckets[b];
+    }
+    for (i = ((size_t)0); i < writer->number_entries; i++) {
+      b = ((size_t)writer->entries[i].hash) & (number_buckets - ((size_t)1));
+      entries[buckets[b]] = writer->entries[i];
+      entries[buckets[b]].key_offset += header.data_offset;
+      entries[buckets[b]].value_offset += header.data_offset;
+      buckets[b]++;
+    }
+    for (b = number_buckets; b > ((size_t)0); b--) {
+      buckets[b] = buckets[b - ((size_t)1)];
+    }
+    buckets[0] = (uint64_t)0;
+  }
+
+  a = (uint64_t)1;
+  s = (uint64_t)0;
+  __update_snapshot_checksum(&a, &s, buckets,
+                             (number_buckets + ((size_t)1)) * sizeof(uint64_t));
+  __update_snapshot_checksum(&a, &s, entries,
+                             writer->number_entries * sizeof(__snapshot_entry_t));
+  __update_snapshot_checksum(&a, &s, mph_block, mph_len);
+  __update_snapshot_checksum(&a, &s, writer->data, writer->data_len);
+  header.checksum = __finish_snapshot_checksum(a, s);
+
+  res = 0;
+  file = fopen(filename, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Could not open file \"%s\" for writing: %s\n", filename,
+            strerror(errno));
+    res = -1;
+  } else {
+    if ((fwrite(&header, sizeof(header), 1, file) != 1) ||
+        (fwrite(buckets, sizeof(uint64_t), number_buckets + ((size_t)1),
+                file) != (number_buckets + ((size_t)1))) ||
+        (fwrite(entries, sizeof(__snapshot_entry_t), writer->number_entries,
+                file) != writer->number_entries) ||
+        (fwrite(mph_block, 1, mph_len, file) != mph_len) ||
+        (fwrite(writer->data, 1, writer->data_len, file) !=
+         writer->data_len)) {
+      fprintf(stderr, "Could not write to file \"%s\": %s\n", filename,
+              strerror(errno));
+      res = -1;
+    }
+    if (fclose(file) != 0) {
+      fprintf(stderr, "Could not close file \"%s\": %s\n", filename,
+              strerror(errno));
+      res = -1;
+    }
+  }
+
+  if (mph != NULL) delete_mph(mph);
+  free(entries);
+  free(buckets);
+
+  return res;
+}
+
+/* Checks that the header describes a file of the mapped length
+   whose parts are in order and do not overlap
+*/
+static int __check_snapshot_header(const __snapshot_header_t *header,
+                                   size_t len) {
+  uint64_t n, nb;
+
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+    return -1;
+  }
+  if (header->version != SNAPSHOT_VERSION) return -1;
+  if (header->file_len != (uint64_t)len) return -1;
+
+  n = header->number_entries;
+  nb = header->number_buckets;
+  if ((nb == ((uint64_t)0)) || ((nb & (nb - ((uint64_t)1))) != ((uint64_t)0))) {
+    return -1;
+  }
+  if (header->buckets_offset != (uint64_t)sizeof(__snapshot_header_t)) {
+    return -1;
+  }
+  if ((nb >= (((uint64_t)len) / sizeof(uint64_t))) ||
+      (n > (((uint64_t)len) / sizeof(__snapshot_entry_t)))) {
+    return -1;
+  }
+  if (header->entries_offset !=
+      (header->buckets_offset + (nb + ((uint64_t)1)) * sizeof(uint64_t))) {
+    return -1;
+  }
+  if (header->mph_offset !=
+      (header->entries_offset + n * sizeof(__snapshot_entry_t))) {
+    return -1;
+  }
+  /* The offsets are checked before they are subtracted, and a
+     sum that wraps around ends before the part it follows
+  */
+  if (header->mph_offset > ((uint64_t)len)) return -1;
+  if ((header->mph_len > (((uint64_t)len) - header->mph_offset)) ||
+      (header->data_offset != (header->mph_offset + header->mph_len)) ||
+      (header->data_offset < header->mph_offset)) {
+    return -1;
+  }
+  if ((header->mph_len != ((uint64_t)0)) && (nb != ((uint64_t)1))) return -1;
+  if (header->data_offset > header->file_len) return -1;
+
+  return 0;
+}
+
+/* Checks the checksum, the bucket indices and that all keys
+   and values lie within the data part of the file
+*/
+static int __verify_snapshot(snapshot_t *snapshot) {
+  const __snapshot_header_t *header = snapshot->header;
+  const __snapshot_entry_t *entry;
+  uint64_t a, s, i;
+
+  a = (uint64_t)1;
+  s = (uint64_t)0;
+  __update_snapshot_checksum(&a, &s, &(snapshot->mapping[sizeof(*header)]),
+                             snapshot->mapping_len - sizeof(*header));
+  if (__finish_snapshot_checksum(a, s) != header->checksum) return -1;
+
+  for (i = ((uint64_t)0); i < header->number_buckets; i++) {
+    if (snapshot->buckets[i] > snapshot->buckets[i + ((uint64_t)1)]) return -1;
+  }
+  for (i = ((uint64_t)0); i < header->number_entries; i++) {
+    entry = &(snapshot->entries[i]);
+    if ((entry->key_offset < header->data_offset) ||
+        (entry->key_len > (header->file_len - entry->key_offset)) ||
+        (entry->value_offset < header->data_offset) ||
+        (entry->value_len > (header->file_len - entry->value_offset))) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+snapshot_t *open_snapshot(const char *filename, int verify) {
+  int fd;
+  struct stat st;
+  void *mapping;
+  snapshot_t *snapshot;
+
+  fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Could not open file \"%s\" for reading: %s\n", filename,
+            strerror(errno));
+    return NULL;
+  }
+  if (fstat(fd, &st) < 0) {
+    fprintf(stderr, "Could not stat file \"%s\": %s\n", filename,
+            strerror(errno));
+    close(fd);
+    return NULL;
+  }
+  if (((size_t)st.st_size) < sizeof(__snapshot_header_t)) {
+    fprintf(stderr, "File \"%s\" is not a snapshot\n", filename);
+    close(fd);
+    return NULL;
+  }
+
+  mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd,
+                 (off_t)0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    fprintf(stderr, "Could not map file \"%s\": %s\n", filename,
+            strerror(errno));
+    return NULL;
+  }
+
+  snapshot = (snapshot_t *)calloc(1, sizeof(snapshot_t));
+  if (snapshot == NULL) error_no_mem();
+  snapshot->mapping = mapping;
+  snapshot->mapping_len = (size_t)st.st_size;
+  snapshot->header = mapping;
+
+  if (__check_snapshot_header(snapshot->header, snapshot->mapping_len) < 0) {
+    fprintf(stderr, "File \"%s\" is not a snapshot of version %u\n", filename,
+            (unsigned int)SNAPSHOT_VERSION);
+    close_snapshot(snapshot);
+    return NULL;
+  }
+  if (snapshot->header->hash_family != (uint32_t)get_hash_family()) {
+    fprintf(stderr,
+            "Snapshot \"%s\" has been written with another hash family\n",
+            filename);
+    close_snapshot(snapshot);
+    return NULL;
+  }
+
+  snapshot->buckets =
+      (const uint64_t *)&(snapshot->mapping[snapshot->header->buckets_offset]);
+  snapshot->entries = (const __snapshot_entry_t *)&(
+      snapshot->mapping[snapshot->header->entries_offset]);
+  snapshot->mask =
+      ((size_t)snapshot->header->number_buckets) - ((size_t)1);
+  if (snapshot->header->mph_len != ((uint64_t)0)) {
+    snapshot->mph =
+        open_mph(&(snapshot->mapping[snapshot->header->mph_offset]),
+                 (size_t)snapshot->header->mph_len);
+    if ((snapshot->mph == NULL) ||
+        (number_keys_in_mph(snapshot->mph) !=
+         (size_t)snapshot->header->number_entries)) {
+      fprintf(stderr, "Snapshot \"%s\" is corrupted\n", filename);
+      close_snapshot(snapshot);
+      return NULL;
+    }
+  }
+
+  if ((snapshot->buckets[snapshot->header->number_buckets] !=
+       snapshot->header->number_entries) ||
+      (verify && (__verify_snapshot(snapshot) < 0))) {
+    fprintf(stderr, "Snapshot \"%s\" is corrupted\n", filename);
+    close_snapshot(snapshot);
+    return NULL;
+  }
+
+  return snapshot;
+}
+
+void close_snapshot(snapshot_t *snapshot) {
+  if (snapshot->mph != NULL) delete_mph(snapshot->mph);
+  munmap((void *)snapshot->mapping, snapshot->mapping_len);
+  free(snapshot);
+}
+
+const void *lookup_in_snapshot(snapshot_t *snapshot, const void *key,
+                               size_t key_len, size_t *value_len) {
+  uint64_t hash;
+  size_t b;
+  uint64_t i, end;
+  const __snapshot_entry_t *entry;
+
+  hash = hash_mem64(key, key_len);
+  if (snapshot->mph != NULL) {
+    /* A single probe */
+    i = (uint64_t)lookup_in_mph(snapshot->mph, hash);
+    if (i >= snapshot->header->number_entries) return NULL;
+    end = i + ((uint64_t)1);
+  } else {
+    b = ((size_t)hash) & snapshot->mask;
+    i = snapshot->buckets[b];
+    end = snapshot->buckets[b + ((size_t)1)];
+  }
+
+  for (; i < end; i++) {
+    entry = &(snapshot->entries[i]);
+    if ((entry->hash == hash) &&
+        (entry->key_len == (uint64_t)key_len) &&
+        (memcmp(&(snapshot->mapping[entry->key_offset]), key, key_len) == 0)) {
+      if (value_len != NULL) *value_len = (size_t)entry->value_len;
+      return &(snapshot->mapping[entry->value_offset]);
+    }
+  }
+
+  return NULL;
+}
+
+size_t number_entries_in_snapshot(snapshot_t *snapshot) {
+  return (size_t)snapshot->header->number_entries;
+}
+
+size_t max_number_collisions_in_snapshot(snapshot_t *snapshot) {
+  uint64_t i, k, l;
+
+  if (snapshot->mph != NULL) return 0;
+
+  k = (uint64_t)0;
+  for (i = ((uint64_t)0); i < snapshot->header->number_buckets; i++) {
+    l = snapshot->buckets[i + ((uint64_t)1)] - snapshot->buckets[i];
+    if (l > k) k = l;
+  }
+
+  if (k == ((uint64_t)0)) return 0;
+
+  return (size_t)(k - ((uint64_t)1));
+}
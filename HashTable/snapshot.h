@@ -0,0 +1,104 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* A snapshot is a read-only hashtable from byte strings to byte
+   strings stored in a single position-independent file, which is
+   mapped into memory and queried in place, without rebuilding.
+
+   The file starts with a header holding a magic number, a format
+   version, the hash family the keys have been hashed with and a
+   checksum of everything that follows the header. Then come the
+   buckets, the entries sorted by bucket, the flat block of a
+   minimal perfect hash function and the key and value bytes.
+   All references inside the file are offsets from its start.
+
+   When all keys are different, the entries are indexed with
+   the minimal perfect hash function instead of buckets, about
+   3 bits per key instead of a 64-bit bucket offset per key,
+   and every lookup probes a single entry.
+*/
+typedef struct __snapshot_writer_struct_t snapshot_writer_t;
+typedef struct __snapshot_struct_t snapshot_t;
+
+/* Creates a snapshot writer with no entries
+
+   O(1)
+*/
+snapshot_writer_t *create_snapshot_writer(void);
+
+/* Deletes a snapshot writer
+
+   O(1)
+*/
+void delete_snapshot_writer(snapshot_writer_t *writer);
+
+/* Adds a key->value pair to a snapshot writer, copying both.
+   The key is hashed with hash_mem64.
+
+   O(1) amortized
+
+   If the same key is added several times, lookups in the
+   written snapshot find the value added first.
+*/
+void add_to_snapshot_writer(snapshot_writer_t *writer, const void *key,
+                            size_t key_len, const void *value,
+                            size_t value_len);
+
+/* Writes all pairs added to a snapshot writer into a snapshot
+   file, building the minimal perfect hash function over the
+   keys unless some of them are equal. Returns 0 on success.
+   Prints a message and returns -1 if the file cannot be
+   written.
+
+   O(n)
+*/
+int write_snapshot(snapshot_writer_t *writer, const char *filename);
+
+/* Opens a snapshot file by mapping it into memory. If verify
+   is non-zero, the checksum of the whole file is checked, which
+   reads every page of it.
+
+   O(1) without verification, O(n) with verification.
+
+   Prints a message and returns NULL if the file cannot be
+   opened, is not a snapshot of this version, has been written
+   with another hash family than the current one or fails the
+   checks.
+*/
+snapshot_t *open_snapshot(const char *filename, int verify);
+
+/* Unmaps a snapshot file
+
+   O(1)
+*/
+void close_snapshot(snapshot_t *snapshot);
+
+/* Lookup a key in a snapshot. Returns a pointer to the value
+   bytes inside the mapping and stores their number in
+   value_len. Returns NULL if the key is not found.
+
+   O(1) with a minimal perfect hash function or if no
+   collisions, O(n) if collisions.
+*/
+const void *lookup_in_snapshot(snapshot_t *snapshot, const void *key,
+                               size_t key_len, size_t *value_len);
+
+/* Returns the number of entries in the snapshot
+
+   O(1)
+*/
+size_t number_entries_in_snapshot(snapshot_t *snapshot);
+
+/* Returns the maximum number of collisions in the snapshot,
+   i.e. the number of entries in the largest bucket minus 1,
+   or 0 if the snapshot has no entries or is indexed with a
+   minimal perfect hash function.
+
+   O(n)
+*/
+size_t max_number_collisions_in_snapshot(snapshot_t *snapshot);
+
+#endif
@@ -0,0 +1,319 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "swisstable.h"
+
+struct __swiss_hashtable_slot_struct_t {
+  void *key;
+  void *value;
+  uint32_t hash;
+};
+
+/* Control byte of an empty slot. The control byte of a full
+   slot has its top bit clear.
+*/
+#define CTRL_EMPTY ((uint8_t)0x80)
+#define CTRL_TAG(hash) ((uint8_t)((hash) & ((uint32_t)0x7f)))
+
+static void error_no_mem(void) {
+  fprintf(stderr, "Error: no memory left.\n");
+  exit(1);
+}
+
+/* Returns a mask with bit i set iff the control byte i of
+   the group starting at ctrl equals tag
+*/
+static unsigned int __match_swiss_group(const uint8_t *ctrl, uint8_t tag) {
+#if defined(__SSE2__)
+  __m128i group;
+
+  group = _mm_loadu_si128((const __m128i *)ctrl);
+  return (unsigned int)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+#else
+  size_t i;
+  unsigned int mask;
+
+  mask = 0U;
+  for (i = ((size_t)0); i < SWISS_GROUP_SIZE; ++i) {
+    if (ctrl[i] == tag) mask |= (1U << i);
+  }
+
+  return mask;
+#endif
+}
+
+/* Returns the index of the lowest bit set in a non-zero mask */
+static size_t __lowest_bit(unsigned int mask) {
+#if defined(__GNUC__)
+  return (size_t)__builtin_ctz(mask);
+#else
+  size_t i;
+
+  for (i = ((size_t)0); (mask & 1U) == 0U; ++i) mask >>= 1;
+
+  return i;
+#endif
+}
+
+/* Returns the group probed first for a hash. The low 7 bits
+   go into the control bytes, so the group is taken from the
+   bits above them.
+*/
+static size_t __swiss_home_group(size_t number_groups, uint32_t hash) {
+  return ((size_t)(hash >> 7)) & (number_groups - ((size_t)1));
+}
+
+/* Returns the number of groups probed before the group holding
+   the slot idx, whose hash is given
+*/
+static size_t __swiss_probe_steps(size_t number_groups, uint32_t hash,
+                                  size_t idx) {
+  size_t mask, group, steps;
+
+  mask = number_groups - ((size_t)1);
+  group = __swiss_home_group(number_groups, hash);
+  for (steps = ((size_t)0); group != (idx / SWISS_GROUP_SIZE); ++steps) {
+    group = (group + steps + ((size_t)1)) & mask;
+  }
+
+  return steps;
+}
+
+/* Returns the number of slots needed to hold n entries at a
+   load factor of at most 7/8. Always a power of 2 and a
+   multiple of the group size.
+*/
+static size_t __swiss_hashtable_slots_for(size_t n) {
+  size_t s;
+
+  s = SWISS_GROUP_SIZE;
+  while ((s - (s >> 3)) < n) s <<= 1;
+
+  return s;
+}
+
+static void __alloc_swiss_hashtable_slots(swiss_hashtable_t *hashtable,
+                                          size_t n) {
+  hashtable->ctrl = (uint8_t *)malloc(n);
+  if (hashtable->ctrl == NULL) error_no_mem();
+  memset(hashtable->ctrl, CTRL_EMPTY, n);
+
+  hashtable->slots =
+      (swiss_hashtable_slot_t *)calloc(n, sizeof(swiss_hashtable_slot_t));
+  if (hashtable->slots == NULL) error_no_mem();
+
+  hashtable->size = n;
+}
+
+swiss_hashtable_t *create_swiss_hashtable(size_t const size) {
+  swiss_hashtable_t *hashtable;
+
+  hashtable = (swiss_hashtable_t *)calloc(1, sizeof(swiss_hashtable_t));
+  if (hashtable == NULL) error_no_mem();
+
+  __alloc_swiss_hashtable_slots(hashtable, __swiss_hashtable_slots_for(size));
+  hashtable->number_entries = (size_t)0;
+
+  return hashtable;
+}
+
+void delete_swiss_hashtable(swiss_hashtable_t *hashtable,
+                            void (*delete_key)(void *, void *),
+                            void (*delete_value)(void *, void *), void *data) {
+  size_t i;
+
+  for (i = ((size_t)0); i < hashtable->size; ++i) {
+    if (hashtable->ctrl[i] != CTRL_EMPTY) {
+      delete_key(hashtable->slots[i].key, data);
+      delete_value(hashtable->slots[i].value, data);
+    }
+  }
+
+  free(hashtable->ctrl);
+  free(hashtable->slots);
+  free(hashtable);
+}
+
+void *lookup_in_swiss_hashtable(swiss_hashtable_t *hashtable, void *key,
+                                uint32_t (*hash_key)(void *, void *),
+                                int (*compare_keys)(void *, void *, void *),
+                                void *data) {
+  uint32_t hash;
+  uint8_t tag;
+  size_t mask, group, steps, idx;
+  unsigned int match;
+  const uint8_t *ctrl;
+  swiss_hashtable_slot_t *slot;
+  void *value;
+
+  hash = hash_key(key, data);
+  tag = CTRL_TAG(hash);
+  mask = (hashtable->size / SWISS_GROUP_SIZE) - ((size_t)1);
+  group = __swiss_home_group(hashtable->size / SWISS_GROUP_SIZE, hash);
+  value = NULL;
+
+  /* Entries are never removed, so an entry added later than
+     another one with the same key sits further along the probe
+     sequence. The last match before a group with an empty slot
+     is the value added last.
+  */
+  for (steps = ((size_t)0);; ++steps) {
+    ctrl = &(hashtable->ctrl[group * SWISS_GROUP_SIZE]);
+    for (match = __match_swiss_group(ctrl, tag); match != 0U;
+         match &= match - 1U) {
+      idx = group * SWISS_GROUP_SIZE + __lowest_bit(match);
+      slot = &(hashtable->slots[idx]);
+      if ((slot->hash == hash) && (compare_keys(key, slot->key, data) == 0)) {
+        value = slot->value;
+      }
+    }
+    if (__match_swiss_group(ctrl, CTRL_EMPTY) != 0U) return value;
+    group = (group + steps + ((size_t)1)) & mask;
+  }
+}
+
+/* Places a slot into the first empty slot of its probe
+   sequence without growing the table and without looking at
+   the keys
+*/
+static void __place_swiss_hashtable_slot(swiss_hashtable_t *hashtable,
+                                         swiss_hashtable_slot_t placed) {
+  size_t mask, group, steps, idx;
+  unsigned int empty;
+
+  mask = (hashtable->size / SWISS_GROUP_SIZE) - ((size_t)1);
+  group = __swiss_home_group(hashtable->size / SWISS_GROUP_SIZE, placed.hash);
+
+  for (steps = ((size_t)0);; ++steps) {
+    empty = __match_swiss_group(&(hashtable->ctrl[group * SWISS_GROUP_SIZE]),
+                                CTRL_EMPTY);
+    if (empty != 0U) {
+      idx = group * SWISS_GROUP_SIZE + __lowest_bit(empty);
+      hashtable->ctrl[idx] = CTRL_TAG(placed.hash);
+      hashtable->slots[idx] = placed;
+      return;
+    }
+    group = (group + steps + ((size_t)1)) & mask;
+  }
+}
+
+/* Moves all entries to a table of new_size slots. Entries with
+   the same hash are moved in the order of their old probe
+   sequence, so that lookups still find the value added last.
+*/
+static void __resize_swiss_hashtable(swiss_hashtable_t *hashtable,
+                                     size_t new_size) {
+  size_t i, k, old_size, old_groups, max_steps;
+  uint8_t *old_ctrl;
+  swiss_hashtable_slot_t *old_slots;
+  size_t *steps;
+
+  old_size = hashtable->size;
+  old_groups = old_size / SWISS_GROUP_SIZE;
+  old_ctrl = hashtable->ctrl;
+  old_slots = hashtable->slots;
+
+  steps = (size_t *)calloc(old_size, sizeof(size_t));
+  if (steps == NULL) error_no_mem();
+  max_steps = (size_t)0;
+  for (i = ((size_t)0); i < old_size; ++i) {
+    if (old_ctrl[i] != CTRL_EMPTY) {
+      steps[i] = __swiss_probe_steps(old_groups, old_slots[i].hash, i);
+      if (steps[i] > max_steps) max_steps = steps[i];
+    }
+  }
+
+  __alloc_swiss_hashtable_slots(hashtable, new_size);
+
+  for (k = ((size_t)0); k <= max_steps; ++k) {
+    for (i = ((size_t)0); i < old_size; ++i) {
+      if ((old_ctrl[i] != CTRL_EMPTY) && (steps[i] == k)) {
+        __place_swiss_hashtable_slot(hashtable, old_slots[i]);
+      }
+    }
+  }
+
+  free(steps);
+  free(old_ctrl);
+  free(old_slots);
+}
+
+void reserve_swiss_hashtable(swiss_hashtable_t *hashtable,
+                             size_t number_entries) {
+  size_t new_size;
+
+  new_size = __swiss_hashtable_slots_for(number_entries);
+  if (new_size > hashtable->size) {
+    __resize_swiss_hashtable(hashtable, new_size);
+  }
+}
+
+void add_hashed_to_swiss_hashtable(swiss_hashtable_t *hashtable, void *key,
+                                   void *value, uint32_t hash,
+                                   void *(*copy_key)(void *, void *),
+                                   void *(*copy_value)(void *, void *),
+                                   void *data) {
+  swiss_hashtable_slot_t added_slot;
+
+  if ((hashtable->number_entries + ((size_t)1)) >
+      (hashtable->size - (hashtable->size >> 3))) {
+    __resize_swiss_hashtable(hashtable, hashtable->size << 1);
+  }
+
+  added_slot.key = copy_key(key, data);
+  added_slot.value = copy_value(value, data);
+  added_slot.hash = hash;
+
+  __place_swiss_hashtable_slot(hashtable, added_slot);
+  hashtable->number_entries++;
+}
+
+void add_to_swiss_hashtable(swiss_hashtable_t *hashtable, void *key,
+                            void *value, void *(*copy_key)(void *, void *),
+                            void *(*copy_value)(void *, void *),
+                            uint32_t (*hash_key)(void *, void *), void *data) {
+  add_hashed_to_swiss_hashtable(hashtable, key, value, hash_key(key, data),
+                                copy_key, copy_value, data);
+}
+
+void iterate_over_swiss_hashtable(swiss_hashtable_t *hashtable,
+                                  void (*f)(void *, void *, void *),
+                                  void *data) {
+  size_t i;
+
+  for (i = ((size_t)0); i < hashtable->size; ++i) {
+    if (hashtable->ctrl[i] != CTRL_EMPTY) {
+      f(hashtable->slots[i].key, hashtable->slots[i].value, data);
+    }
+  }
+}
+
+size_t number_entries_in_swiss_hashtable(swiss_hashtable_t *hashtable) {
+  return hashtable->number_entries;
+}
+
+size_t max_number_collisions_in_swiss_hashtable(swiss_hashtable_t *hashtable) {
+  size_t i, k, l;
+
+  k = (size_t)0;
+  for (i = ((size_t)0); i < hashtable->size; ++i) {
+    if (hashtable->ctrl[i] != CTRL_EMPTY) {
+      l = __swiss_probe_steps(hashtable->size / SWISS_GROUP_SIZE,
+                              hashtable->slots[i].hash, i);
+      if (l > k) k = l;
+    }
+  }
+
+  return k;
+}
+
+size_t number_empty_entries_in_swiss_hashtable(swiss_hashtable_t *hashtable) {
+  return hashtable->size - hashtable->number_entries;
+}
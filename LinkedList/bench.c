@@ -0,0 +1,516 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "allocator.h"
+#include "intrusivelists.h"
+#include "linkedlists.h"
+#include "unrolledlists.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES_UNIT "cycle"
+#else
+#define CYCLES_UNIT "ns"
+#endif
+
+/* Number of elements visited by each measurement, whatever
+   the length of the lists
+*/
+#define VISITS (((size_t)1) << 24)
+
+/* Returns the time stamp counter where available,
+   nanoseconds otherwise
+*/
+static uint64_t read_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return (uint64_t)__rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec) * ((uint64_t)1000000000) + ((uint64_t)ts.tv_nsec);
+#endif
+}
+
+/* The elements are the integers 1, ..., n cast to pointers */
+static void *bench_copy(void *elem, void *data) { return elem; }
+
+static void bench_delete(void *elem, void *data) {}
+
+static void bench_sum(void *elem, void *data) {
+  uintptr_t *sum = data;
+
+  *sum += (uintptr_t)elem;
+}
+
+static int bench_compare(void *a, void *b, void *data) { return (a != b); }
+
+/* Builds a list_t and an unrolled list of n elements, then
+   iterates over both and searches both for an absent element,
+   as many times as needed to visit VISITS elements
+*/
+static void bench_lists_size(size_t n) {
+  list_t *list;
+  unrolled_list_t *unrolled_list;
+  size_t i, r, runs;
+  uint64_t start, mid, stop;
+  uintptr_t sum, unrolled_sum;
+  void *found;
+
+  list = create_list();
+  unrolled_list = create_unrolled_list();
+  for (i = ((size_t)1); i <= n; i++) {
+    append_to_list(list, (void *)(uintptr_t)i, bench_copy, NULL);
+    append_to_unrolled_list(unrolled_list, (void *)(uintptr_t)i, bench_copy,
+                            NULL);
+  }
+  runs = VISITS / n;
+  if (runs < ((size_t)1)) runs = (size_t)1;
+
+  sum = (uintptr_t)0;
+  unrolled_sum = (uintptr_t)0;
+  start = read_cycles();
+  for (r = ((size_t)0); r < runs; r++) {
+    iterate_over_list(list, bench_sum, &sum);
+  }
+  mid = read_cycles();
+  for (r = ((size_t)0); r < runs; r++) {
+    iterate_over_unrolled_list(unrolled_list, bench_sum, &unrolled_sum);
+  }
+  stop = read_cycles();
+  printf("  %8zu elements: iterate list %6.2f, unrolled %6.2f %ss/element",
+         n, ((double)(mid - start)) / ((double)(runs * n)),
+         ((double)(stop - mid)) / ((double)(runs * n)), CYCLES_UNIT);
+
+  found = NULL;
+  start = read_cycles();
+  for (r = ((size_t)0); r < runs; r++) {
+    found = search_list(list, NULL, bench_compare, NULL);
+  }
+  mid = read_cycles();
+  for (r = ((size_t)0); r < runs; r++) {
+    if (search_unrolled_list(unrolled_list, NULL, bench_compare, NULL) !=
+        found) {
+      found = unrolled_list;
+    }
+  }
+  stop = read_cycles();
+  printf(", search list %6.2f, unrolled %6.2f (%s)\n",
+         ((double)(mid - start)) / ((double)(runs * n)),
+         ((double)(stop - mid)) / ((double)(runs * n)),
+         (((sum == unrolled_sum) && (found == NULL)) ? "same results"
+                                                      : "DIFFERENT RESULTS"));
+
+  delete_unrolled_list(unrolled_list, bench_delete, NULL);
+  delete_list(list, bench_delete, NULL);
+}
+
+static void bench_lists(void) {
+  size_t n;
+
+  printf("list_t vs. unrolled list of %zu elements per node:\n",
+         UNROLLED_NODE_ELEMENTS);
+  for (n = ((size_t)1000); n <= ((size_t)10000000); n *= ((size_t)10)) {
+    bench_lists_size(n);
+  }
+}
+
+/* Reads the elements of a list of n elements by index, in
+   order and then in random order
+*/
+static void bench_ith_size(size_t n) {
+  list_t *list;
+  size_t i;
+  uint64_t start, mid, stop, x;
+  uintptr_t sum, random_sum;
+
+  list = create_list();
+  for (i = ((size_t)1); i <= n; i++) {
+    append_to_list(list, (void *)(uintptr_t)i, bench_copy, NULL);
+  }
+
+  sum = (uintptr_t)0;
+  start = read_cycles();
+  for (i = ((size_t)0); i < n; i++) {
+    sum += (uintptr_t)get_ith_element_of_list(list, i);
+  }
+  mid = read_cycles();
+  random_sum = (uintptr_t)0;
+  x = (uint64_t)1;
+  for (i = ((size_t)0); i < n; i++) {
+    x = x * ((uint64_t)6364136223846793005ull) + ((uint64_t)1442695040888963407ull);
+    random_sum += (uintptr_t)get_ith_element_of_list(
+        list, (size_t)((x >> 33) % ((uint64_t)n)));
+  }
+  stop = read_cycles();
+  printf("  %8zu elements: in order %10.2f, random %10.2f %ss/access (%s)\n",
+         n, ((double)(mid - start)) / ((double)n),
+         ((double)(stop - mid)) / ((double)n), CYCLES_UNIT,
+         ((sum == (((uintptr_t)n) * ((uintptr_t)(n + ((size_t)1)))) /
+                      ((uintptr_t)2))
+              ? "same results"
+              : "DIFFERENT RESULTS"));
+
+  delete_list(list, bench_delete, NULL);
+}
+
+static void bench_ith(void) {
+  size_t n;
+
+  printf("get_ith_element_of_list:\n");
+  for (n = ((size_t)1000); n <= ((size_t)100000); n *= ((size_t)10)) {
+    bench_ith_size(n);
+  }
+}
+
+/* An element allocated on its own, with the links of an
+   intrusive list embedded in it
+*/
+typedef struct {
+  uint64_t value;
+  list_link_t link;
+} bench_element_t;
+
+static bench_element_t *bench_alloc_element(size_t i) {
+  bench_element_t *element;
+
+  element = (bench_element_t *)malloc(sizeof(bench_element_t));
+  if (element == NULL) {
+    fprintf(stderr, "Error: no memory left.\n");
+    exit(1);
+  }
+  element->value = (uint64_t)i;
+
+  return element;
+}
+
+static void bench_free_element(void *elem, void *data) { free(elem); }
+
+/* Allocates and frees as many blocks as the elements of both
+   lists and the nodes of the list_t, so that the list built
+   first does not pay alone for the page faults of a growing
+   heap
+*/
+static void bench_warm_heap(size_t n) {
+  void **blocks;
+  size_t i;
+
+  blocks = (void **)calloc(((size_t)3) * n, sizeof(void *));
+  if (blocks == NULL) {
+    fprintf(stderr, "Error: no memory left.\n");
+    exit(1);
+  }
+  for (i = ((size_t)0); i < ((size_t)3) * n; i++) {
+    blocks[i] = malloc(sizeof(node_t));
+  }
+  for (i = ((size_t)0); i < ((size_t)3) * n; i++) {
+    free(blocks[i]);
+  }
+  free(blocks);
+}
+
+static void bench_sum_element(void *elem, void *data) {
+  uint64_t *sum = data;
+
+  *sum += ((bench_element_t *)elem)->value;
+}
+
+static void bench_free_link(list_link_t *link, void *data) {
+  free(CONTAINER_OF(link, bench_element_t, link));
+}
+
+static void bench_sum_link(list_link_t *link, void *data) {
+  uint64_t *sum = data;
+
+  *sum += CONTAINER_OF(link, bench_element_t, link)->value;
+}
+
+/* Builds a list_t of n elements allocated on their own, which
+   it reaches through its nodes, and an intrusive list of as
+   many elements linked by their embedded links. Iterates over
+   both, as many times as needed to visit VISITS elements, and
+   deletes both with their elements.
+*/
+static void bench_intrusive_size(size_t n) {
+  list_t *list;
+  intrusive_list_t intrusive_list;
+  size_t i, r, runs;
+  uint64_t start, stop, sum, intrusive_sum;
+  uint64_t build, intrusive_build, iterate, intrusive_iterate;
+  uint64_t destroy, intrusive_destroy;
+
+  runs = VISITS / n;
+  if (runs < ((size_t)1)) runs = (size_t)1;
+  bench_warm_heap(n);
+
+  start = read_cycles();
+  list = create_list();
+  for (i = ((size_t)1); i <= n; i++) {
+    append_to_list(list, bench_alloc_element(i), bench_copy, NULL);
+  }
+  stop = read_cycles();
+  build = stop - start;
+  sum = (uint64_t)0;
+  start = read_cycles();
+  for (r = ((size_t)0); r < runs; r++) {
+    iterate_over_list(list, bench_sum_element, &sum);
+  }
+  stop = read_cycles();
+  iterate = stop - start;
+  start = read_cycles();
+  delete_list(list, bench_free_element, NULL);
+  stop = read_cycles();
+  destroy = stop - start;
+
+  start = read_cycles();
+  init_intrusive_list(&intrusive_list);
+  for (i = ((size_t)1); i <= n; i++) {
+    append_to_intrusive_list(&intrusive_list, &(bench_alloc_element(i)->link));
+  }
+  stop = read_cycles();
+  intrusive_build = stop - start;
+  intrusive_sum = (uint64_t)0;
+  start = read_cycles();
+  for (r = ((size_t)0); r < runs; r++) {
+    iterate_over_intrusive_list(&intrusive_list, bench_sum_link,
+                                &intrusive_sum);
+  }
+  stop = read_cycles();
+  intrusive_iterate = stop - start;
+  start = read_cycles();
+  iterate_over_intrusive_list(&intrusive_list, bench_free_link, NULL);
+  init_intrusive_list(&intrusive_list);
+  stop = read_cycles();
+  intrusive_destroy = stop - start;
+
+  printf("  %8zu elements: build list %6.2f, intrusive %6.2f, iterate list "
+         "%6.2f, intrusive %6.2f, delete list %6.2f, intrusive %6.2f "
+         "%ss/element (%s)\n",
+         n, ((double)build) / ((double)n),
+         ((double)intrusive_build) / ((double)n),
+         ((double)iterate) / ((double)(runs * n)),
+         ((double)intrusive_iterate) / ((double)(runs * n)),
+         ((double)destroy) / ((double)n),
+         ((double)intrusive_destroy) / ((double)n), CYCLES_UNIT,
+         ((sum == intrusive_sum) ? "same results" : "DIFFERENT RESULTS"));
+}
+
+static void bench_intrusive(void) {
+  size_t n;
+
+  printf("list_t vs. intrusive list of elements allocated on their own:\n");
+  for (n = ((size_t)1000); n <= ((size_t)1000000); n *= ((size_t)10)) {
+    bench_intrusive_size(n);
+  }
+}
+
+#define NODES_LENGTH (((size_t)1) << 16)
+#define NODES_OPS (((size_t)1) << 22)
+/* Number of nodes moved by each split */
+#define NODES_SPLIT ((size_t)8)
+
+/* Returns non-zero if a list holds 1, ..., n in order */
+static int bench_check_list(list_t *list, size_t n) {
+  node_t *curr;
+  size_t i;
+
+  if (length_list(list) != n) return 0;
+  i = (size_t)1;
+  for (curr = list->head; curr != NULL; curr = curr->next) {
+    if (((uintptr_t)curr->data) != ((uintptr_t)i)) return 0;
+    i++;
+  }
+
+  return ((i - ((size_t)1)) == n);
+}
+
+/* Runs the node operations on a list of NODES_LENGTH elements,
+   allocated with malloc or in a pool of its own, each sequence
+   of operations leaving the list as it was:
+   - unlink_node and link_after rotate the tail to the front,
+   - remove_node and insert_after rotate the head to the back,
+   - split_list_at and splice_lists split the last NODES_SPLIT
+     nodes off and splice them back.
+   Finally splits the list in halves and deletes the first half
+   before the second one, which still holds the pool.
+*/
+static void bench_nodes_run(int pooled) {
+  list_t *list, *rest;
+  node_t *node;
+  size_t i, k;
+  uint64_t start, mid, stop;
+  int ok;
+
+  list = (pooled ? create_list_with_pool() : create_list());
+  for (i = ((size_t)1); i <= NODES_LENGTH; i++) {
+    append_to_list(list, (void *)(uintptr_t)i, bench_copy, NULL);
+  }
+
+  start = read_cycles();
+  for (i = ((size_t)0); i < NODES_OPS; i++) {
+    node = list->tail;
+    unlink_node(list, node);
+    link_after(list, NULL, node);
+  }
+  mid = read_cycles();
+  for (i = ((size_t)0); i < NODES_OPS; i++) {
+    insert_after(list, list->tail, remove_node(list, list->head), bench_copy,
+                 NULL);
+  }
+  stop = read_cycles();
+  ok = bench_check_list(list, NODES_LENGTH);
+  printf("  %-6s: unlink and link %6.2f, remove and insert %6.2f",
+         (pooled ? "pool" : "malloc"),
+         ((double)(mid - start)) / ((double)NODES_OPS),
+         ((double)(stop - mid)) / ((double)NODES_OPS));
+
+  start = read_cycles();
+  for (i = ((size_t)0); i < (NODES_OPS / NODES_SPLIT); i++) {
+    node = list->tail;
+    for (k = ((size_t)1); k < NODES_SPLIT; k++) node = node->prev;
+    rest = split_list_at(list, node);
+    splice_lists(list, rest);
+    delete_list(rest, bench_delete, NULL);
+  }
+  stop = read_cycles();
+  ok = ok && bench_check_list(list, NODES_LENGTH);
+  printf(", split and splice %6.2f %ss/operation",
+         ((double)(stop - start)) / ((double)(NODES_OPS / NODES_SPLIT)),
+         CYCLES_UNIT);
+
+  node = list->head;
+  for (i = ((size_t)0); i < (NODES_LENGTH >> 1); i++) node = node->next;
+  rest = split_list_at(list, node);
+  ok = ok && bench_check_list(list, NODES_LENGTH >> 1);
+  delete_list(list, bench_delete, NULL);
+  ok = ok && (length_list(rest) == (NODES_LENGTH - (NODES_LENGTH >> 1))) &&
+       (((uintptr_t)rest->head->data) ==
+        ((uintptr_t)((NODES_LENGTH >> 1) + ((size_t)1))));
+  delete_list(rest, bench_delete, NULL);
+  printf(" (%s)\n", (ok ? "same results" : "DIFFERENT RESULTS"));
+}
+
+static void bench_nodes(void) {
+  printf("Node operations on a list of %zu elements:\n", NODES_LENGTH);
+  bench_nodes_run(0);
+  bench_nodes_run(1);
+}
+
+#define CHURN_LISTS ((size_t)1024)
+#define CHURN_MAX_LENGTH ((size_t)64)
+#define CHURN_APPENDS (((size_t)1) << 23)
+
+typedef enum { CHURN_MALLOC, CHURN_SHARED_POOL, CHURN_OWN_POOL } churn_t;
+
+static list_t *create_churn_list(churn_t churn, pool_t *pool) {
+  switch (churn) {
+    case CHURN_SHARED_POOL:
+      return create_list_with_allocator(get_pool_allocator(pool));
+    case CHURN_OWN_POOL:
+      return create_list_with_pool();
+    default:
+      return create_list();
+  }
+}
+
+/* Keeps CHURN_LISTS lists alive, and replaces a random one
+   with a new list of random length at each step, until
+   CHURN_APPENDS elements have been appended. Returns the
+   number of cycles per element appended and deleted.
+*/
+static double bench_churn_run(churn_t churn) {
+  list_t *lists[CHURN_LISTS];
+  pool_t *pool;
+  size_t i, k, n, appends;
+  uint64_t start, stop, x;
+
+  pool = create_pool(sizeof(node_t), (size_t)0);
+  for (i = ((size_t)0); i < CHURN_LISTS; i++) {
+    lists[i] = create_churn_list(churn, pool);
+  }
+
+  x = (uint64_t)1;
+  appends = (size_t)0;
+  start = read_cycles();
+  while (appends < CHURN_APPENDS) {
+    x = x * ((uint64_t)6364136223846793005ull) + ((uint64_t)1442695040888963407ull);
+    i = (size_t)((x >> 33) % ((uint64_t)CHURN_LISTS));
+    n = (size_t)((x >> 17) % ((uint64_t)CHURN_MAX_LENGTH));
+    delete_list(lists[i], bench_delete, NULL);
+    lists[i] = create_churn_list(churn, pool);
+    for (k = ((size_t)1); k <= n; k++) {
+      append_to_list(lists[i], (void *)(uintptr_t)k, bench_copy, NULL);
+    }
+    appends += n;
+  }
+  stop = read_cycles();
+
+  for (i = ((size_t)0); i < CHURN_LISTS; i++) {
+    delete_list(lists[i], bench_delete, NULL);
+  }
+  delete_pool(pool);
+
+  return ((double)(stop - start)) / ((double)appends);
+}
+
+static void bench_churn(void) {
+  printf("Append/delete churn over %zu lists of up to %zu elements:\n",
+         CHURN_LISTS, CHURN_MAX_LENGTH);
+  printf("  malloc %6.2f, shared pool %6.2f, pool per list %6.2f "
+         "%ss/element\n",
+         bench_churn_run(CHURN_MALLOC), bench_churn_run(CHURN_SHARED_POOL),
+         bench_churn_run(CHURN_OWN_POOL), CYCLES_UNIT);
+}
+
+static const char *const sections[] = {"unrolled", "ith", "nodes", "pool",
+                                       "intrusive"};
+
+/* Returns non-zero if the section has been asked for on the
+   command line, or if no section has been asked for at all
+*/
+static int selected(int argc, char **argv, const char *section) {
+  int i;
+
+  if (argc < 2) return 1;
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], section) == 0) return 1;
+  }
+
+  return 0;
+}
+
+static void usage(const char *name) {
+  size_t i;
+
+  fprintf(stderr, "Usage: %s [section ...]\nSections:", name);
+  for (i = ((size_t)0); i < (sizeof(sections) / sizeof(sections[0])); i++) {
+    fprintf(stderr, " %s", sections[i]);
+  }
+  fprintf(stderr, "\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  int i;
+  size_t j;
+
+  for (i = 1; i < argc; i++) {
+    for (j = ((size_t)0); j < (sizeof(sections) / sizeof(sections[0])); j++) {
+      if (strcmp(argv[i], sections[j]) == 0) break;
+    }
+    if (j >= (sizeof(sections) / sizeof(sections[0]))) {
+      usage((argc > 0) ? argv[0] : "bench");
+    }
+  }
+
+  if (selected(argc, argv, "unrolled")) bench_lists();
+  if (selected(argc, argv, "ith")) bench_ith();
+  if (selected(argc, argv, "nodes")) bench_nodes();
+  if (selected(argc, argv, "pool")) bench_churn();
+  if (selected(argc, argv, "intrusive")) bench_intrusive();
+
+  return 0;
+}
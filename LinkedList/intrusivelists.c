@@ -0,0 +1,115 @@
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "intrusivelists.h"
+
+void init_intrusive_list(intrusive_list_t *list) {
+  list->head = NULL;
+  list->tail = NULL;
+  list->size = (size_t)0;
+}
+
+int is_empty_intrusive_list(intrusive_list_t *list) {
+  return (list->head == NULL);
+}
+
+size_t length_intrusive_list(intrusive_list_t *list) { return list->size; }
+
+void iterate_over_intrusive_list(intrusive_list_t *list,
+                                 void (*operation)(list_link_t *, void *),
+                                 void *data) {
+  list_link_t *curr, *next;
+
+  for (curr = list->head; curr != NULL; curr = next) {
+    next = curr->next;
+    operation(curr, data);
+  }
+}
+
+list_link_t *search_intrusive_list(
+    intrusive_list_t *list, void *elem,
+    int (*compare_elements)(void *, list_link_t *, void *), void *data) {
+  list_link_t *curr;
+
+  for (curr = list->head; curr != NULL; curr = curr->next) {
+    if (compare_elements(elem, curr, data) == 0) return curr;
+  }
+
+  return NULL;
+}
+
+list_link_t *get_ith_link_of_intrusive_list(intrusive_list_t *list,
+                                            size_t i) {
+  list_link_t *curr;
+  size_t j;
+
+  if (i >= list->size) return NULL;
+
+  if (i <= ((list->size - ((size_t)1)) - i)) {
+    curr = list->head;
+    for (j = ((size_t)0); j < i; j++) curr = curr->next;
+  } else {
+    curr = list->tail;
+    for (j = list->size - ((size_t)1); j > i; j--) curr = curr->prev;
+  }
+
+  return curr;
+}
+
+void prepend_to_intrusive_list(intrusive_list_t *list, list_link_t *link) {
+  insert_link_after(list, NULL, link);
+}
+
+void append_to_intrusive_list(intrusive_list_t *list, list_link_t *link) {
+  insert_link_after(list, list->tail, link);
+}
+
+void insert_link_after(intrusive_list_t *list, list_link_t *position,
+                       list_link_t *link) {
+  link->prev = position;
+  if (position == NULL) {
+    link->next = list->head;
+    list->head = link;
+  } else {
+    link->next = position->next;
+    position->next = link;
+  }
+  if (link->next != NULL) {
+    link->next->prev = link;
+  } else {
+    list->tail = link;
+  }
+  list->size++;
+}
+
+void remove_link(intrusive_list_t *list, list_link_t *link) {
+  if (link->prev != NULL) {
+    link->prev->next = link->next;
+  } else {
+    list->head = link->next;
+  }
+  if (link->next != NULL) {
+    link->next->prev = link->prev;
+  } else {
+    list->tail = link->prev;
+  }
+  link->prev = NULL;
+  link->next = NULL;
+  list->size--;
+}
+
+void splice_intrusive_lists(intrusive_list_t *list,
+                            intrusive_list_t *other) {
+  if (other->head == NULL) return;
+
+  if (list->tail != NULL) {
+    list->tail->next = other->head;
+    other->head->prev = list->tail;
+  } else {
+    list->head = other->head;
+  }
+  list->tail = other->tail;
+  list->size += other->size;
+
+  init_intrusive_list(other);
+}
@@ -0,0 +1,148 @@
+#ifndef __INTRUSIVE_LISTS_H__
+#define __INTRUSIVE_LISTS_H__
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/* The links of an element of an intrusive list, embedded in
+   the structure of the element itself
+*/
+typedef struct __list_link_t {
+  struct __list_link_t *prev;
+  struct __list_link_t *next;
+} list_link_t;
+
+/* size is the number of elements */
+typedef struct {
+  list_link_t *head;
+  list_link_t *tail;
+  size_t size;
+} intrusive_list_t;
+
+/* Returns a pointer to the structure of the given type whose
+   field member is pointed to by ptr, e.g. the element a link
+   returned by search_intrusive_list belongs to:
+
+     typedef struct {
+       uint64_t key;
+       list_link_t link;
+     } element_t;
+
+     element_t *element = CONTAINER_OF(link, element_t, link);
+*/
+#define CONTAINER_OF(ptr, type, member) \
+  ((type *)(((char *)(ptr)) - offsetof(type, member)))
+
+/* Same as CONTAINER_OF, returning NULL for a NULL link, e.g.
+   at the end of a list
+*/
+#define CONTAINER_OF_LINK(link, type, member) \
+  (((link) == NULL) ? ((type *)NULL) : CONTAINER_OF((link), type, member))
+
+/* An intrusive list has the operations of a list_t, but links
+   elements through a list_link_t embedded in them instead of
+   nodes allocated by the list. Adding an element then neither
+   allocates nor copies anything, and iterating reads the links
+   and the element from the same cache lines instead of
+   following a node to a separate element.
+
+   The list never allocates or frees memory: the caller owns
+   both the list and the elements, and an element must stay
+   alive and in place while it is linked. An element with
+   several links may be in several lists at once, one per link.
+*/
+
+/* Makes a list empty, forgetting the elements it may have had
+
+   O(1)
+*/
+void init_intrusive_list(intrusive_list_t *);
+
+/* Returns 0 if the list is not empty, non-zero otherwise
+
+   O(1)
+*/
+int is_empty_intrusive_list(intrusive_list_t *);
+
+/* Returns the length of the list
+
+   O(1)
+*/
+size_t length_intrusive_list(intrusive_list_t *);
+
+/* Iterates over all links of the list, calling the function
+   in argument on each link.
+
+   The function may unlink the link it is given, and free its
+   element, e.g. to empty the list.
+
+   O(n)
+*/
+void iterate_over_intrusive_list(intrusive_list_t *,
+                                 void (*)(list_link_t *, void *), void *);
+
+/* Searches the list for an element, comparing with the
+   function in argument, which is given the sought element and
+   the link of each element of the list.
+
+   The function in argument must return 0 if the
+   elements are indeed equal.
+
+   Returns the link of the first element that is found
+   equal.
+
+   Returns NULL if no element matches.
+
+   O(n)
+*/
+list_link_t *search_intrusive_list(intrusive_list_t *, void *,
+                                   int (*)(void *, list_link_t *, void *),
+                                   void *);
+
+/* Returns the link of the i-th element of the list, walking
+   from the nearest end.
+
+   Returns NULL if the list does not have an i-th element.
+
+   O(min(i, n - i))
+*/
+list_link_t *get_ith_link_of_intrusive_list(intrusive_list_t *, size_t);
+
+/* Links an element not in the list so that it is the new
+   first element of the list
+
+   O(1)
+*/
+void prepend_to_intrusive_list(intrusive_list_t *, list_link_t *);
+
+/* Links an element not in the list so that it is the new
+   last element of the list
+
+   O(1)
+*/
+void append_to_intrusive_list(intrusive_list_t *, list_link_t *);
+
+/* Links an element not in the list right after the element
+   of the list whose link is given first, or at the head of the
+   list if that link is NULL
+
+   O(1)
+*/
+void insert_link_after(intrusive_list_t *, list_link_t *, list_link_t *);
+
+/* Unlinks an element from the list it is in. The element is
+   left untouched apart from its links, which are reset to
+   NULL.
+
+   O(1)
+*/
+void remove_link(intrusive_list_t *, list_link_t *);
+
+/* Moves all elements of the second list to the end of the
+   first one, leaving the second list empty
+
+   O(1)
+*/
+void splice_intrusive_lists(intrusive_list_t *, intrusive_list_t *);
+
+#endif
@@ -1,21 +1,40 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "allocator.h"
 #include "linkedlists.h"
 
-static void error_no_mem(void) {
-  fprintf(stderr, "Error: no memory left.\n");
-  exit(1);
-}
+/* Size of the slabs of the pool of a list created with
+   create_list_with_pool, small enough for short lists
+*/
+#define LIST_POOL_SLAB_SIZE ((size_t)1024)
+
+list_t *create_list(void) { return create_list_with_allocator(NULL); }
 
-list_t *create_list(void) {
+list_t *create_list_with_allocator(allocator_t *allocator) {
   list_t *list;
 
-  list = (list_t *)malloc(sizeof(list_t));
-  if (list == NULL) error_no_mem();
+  list = (list_t *)allocate_memory(allocator, sizeof(list_t));
 
   list->head = NULL;
   list->tail = NULL;
+  list->allocator = allocator;
+  list->pool = NULL;
+  list->size = (size_t)0;
+  list->finger = NULL;
+  list->finger_index = (size_t)0;
+
+  return list;
+}
+
+list_t *create_list_with_pool(void) {
+  list_t *list;
+  pool_t *pool;
+
+  pool = create_pool(sizeof(node_t), LIST_POOL_SLAB_SIZE);
+  list = create_list_with_allocator(NULL);
+  list->allocator = get_pool_allocator(pool);
+  list->pool = pool;
 
   return list;
 }
@@ -24,27 +43,38 @@ void delete_list(list_t *list, void (*delete_data)(void *, void *),
                  void *data) {
   node_t *curr, *next;
 
+  /* A pool still held by lists split from this one takes its
+     nodes back one by one, otherwise it is deleted at once
+  */
+  if (list->pool != NULL) {
+    if (is_shared_pool(list->pool)) {
+      for (curr = list->head; curr != NULL; curr = next) {
+        next = curr->next;
+        delete_data(curr->data, data);
+        free_in_pool(list->pool, curr);
+      }
+    } else {
+      for (curr = list->head; curr != NULL; curr = curr->next) {
+        delete_data(curr->data, data);
+      }
+    }
+    delete_pool(list->pool);
+    free_memory(NULL, list, sizeof(list_t));
+    return;
+  }
+
   for (curr = list->head; curr != NULL; curr = next) {
     next = curr->next;
     delete_data(curr->data, data);
-    free(curr);
+    free_memory(list->allocator, curr, sizeof(node_t));
   }
 
-  free(list);
+  free_memory(list->allocator, list, sizeof(list_t));
 }
 
 int is_empty_list(list_t *list) { return (list->head == NULL); }
 
-size_t length_list(list_t *list) {
-  size_t i;
-  node_t *curr;
-
-  for (i = 0, curr = list->head; curr != NULL; curr = curr->next) {
-    i++;
-  }
-
-  return i;
-}
+size_t length_list(list_t *list) { return list->size; }
 
 void iterate_over_list(list_t *list, void (*operation)(void *, void *),
                        void *data) {
@@ -66,23 +96,54 @@ void *search_list(list_t *list, void *elem,
   return NULL;
 }
 
-void *get_ith_element_of_list(list_t *list, size_t i) {
-  size_t k;
+node_t *search_node_in_list(list_t *list, void *elem,
+                            int (*compare_elements)(void *, void *, void *),
+                            void *data) {
   node_t *curr;
 
-  for (k = 0, curr = list->head; curr != NULL; k++, curr = curr->next) {
-    if (k == i) return curr->data;
+  for (curr = list->head; curr != NULL; curr = curr->next) {
+    if (compare_elements(elem, curr->data, data) == 0) return curr;
   }
 
   return NULL;
 }
 
-void prepend_to_list(list_t *list, void *elem,
-                     void *(*copy_element)(void *, void *), void *data) {
+void *get_ith_element_of_list(list_t *list, size_t i) {
+  size_t k, distance;
+  node_t *curr;
+
+  if (i >= list->size) return NULL;
+
+  /* Starts from the head, the tail or the finger */
+  curr = list->head;
+  k = (size_t)0;
+  distance = i;
+  if ((list->size - ((size_t)1) - i) < distance) {
+    curr = list->tail;
+    k = list->size - ((size_t)1);
+    distance = k - i;
+  }
+  if ((list->finger != NULL) &&
+      (((list->finger_index >= i) ? (list->finger_index - i)
+                                  : (i - list->finger_index)) < distance)) {
+    curr = list->finger;
+    k = list->finger_index;
+  }
+
+  for (; k < i; k++) curr = curr->next;
+  for (; k > i; k--) curr = curr->prev;
+
+  list->finger = curr;
+  list->finger_index = i;
+
+  return curr->data;
+}
+
+node_t *prepend_to_list(list_t *list, void *elem,
+                        void *(*copy_element)(void *, void *), void *data) {
   node_t *new_node;
 
-  new_node = (node_t *)malloc(sizeof(node_t));
-  if (new_node == NULL) error_no_mem();
+  new_node = (node_t *)allocate_memory(list->allocator, sizeof(node_t));
 
   new_node->data = copy_element(elem, data);
   new_node->prev = NULL;
@@ -95,14 +156,17 @@ void prepend_to_list(list_t *list, void *elem,
   if (list->tail == NULL) {
     list->tail = new_node;
   }
+  list->size++;
+  if (list->finger != NULL) list->finger_index++;
+
+  return new_node;
 }
 
-void append_to_list(list_t *list, void *elem,
-                    void *(*copy_element)(void *, void *), void *data) {
+node_t *append_to_list(list_t *list, void *elem,
+                       void *(*copy_element)(void *, void *), void *data) {
   node_t *new_node;
 
-  new_node = (node_t *)malloc(sizeof(node_t));
-  if (new_node == NULL) error_no_mem();
+  new_node = (node_t *)allocate_memory(list->allocator, sizeof(node_t));
 
   new_node->data = copy_element(elem, data);
 
@@ -116,4 +180,146 @@ void append_to_list(list_t *list, void *elem,
   if (list->head == NULL) {
     list->head = new_node;
   }
+  list->size++;
+
+  return new_node;
+}
+
+node_t *insert_after(list_t *list, node_t *node, void *elem,
+                     void *(*copy_element)(void *, void *), void *data) {
+  node_t *new_node;
+
+  if (node == NULL) return prepend_to_list(list, elem, copy_element, data);
+  if (node == list->tail) {
+    return append_to_list(list, elem, copy_element, data);
+  }
+
+  new_node = (node_t *)allocate_memory(list->allocator, sizeof(node_t));
+  new_node->data = copy_element(elem, data);
+  link_after(list, node, new_node);
+
+  return new_node;
+}
+
+void *remove_node(list_t *list, node_t *node) {
+  void *elem;
+
+  elem = node->data;
+  unlink_node(list, node);
+  free_memory(list->allocator, node, sizeof(node_t));
+
+  return elem;
+}
+
+/* The index of the finger is only known to stay the same if
+   the node is after it, which cannot be told in O(1)
+*/
+void unlink_node(list_t *list, node_t *node) {
+  if (node->prev != NULL) {
+    node->prev->next = node->next;
+  } else {
+    list->head = node->next;
+  }
+  if (node->next != NULL) {
+    node->next->prev = node->prev;
+  } else {
+    list->tail = node->prev;
+  }
+  node->prev = NULL;
+  node->next = NULL;
+  list->size--;
+  list->finger = NULL;
+}
+
+void link_after(list_t *list, node_t *node, node_t *new_node) {
+  new_node->prev = node;
+  if (node == NULL) {
+    new_node->next = list->head;
+    list->head = new_node;
+  } else {
+    new_node->next = node->next;
+    node->next = new_node;
+  }
+  if (new_node->next != NULL) {
+    new_node->next->prev = new_node;
+  } else {
+    list->tail = new_node;
+  }
+  list->size++;
+  if (list->finger != NULL) {
+    if (node == NULL) {
+      list->finger_index++;
+    } else if (new_node != list->tail) {
+      list->finger = NULL;
+    }
+  }
+}
+
+void splice_lists(list_t *list, list_t *other) {
+  if (other->head == NULL) return;
+
+  if (list->tail != NULL) {
+    list->tail->next = other->head;
+    other->head->prev = list->tail;
+  } else {
+    list->head = other->head;
+  }
+  list->tail = other->tail;
+  list->size += other->size;
+
+  other->head = NULL;
+  other->tail = NULL;
+  other->size = (size_t)0;
+  other->finger = NULL;
+}
+
+list_t *split_list_at(list_t *list, node_t *node) {
+  list_t *rest;
+  node_t *forward, *backward;
+  size_t moved, kept;
+
+  /* The new list holds the pool of a pooled list as well, as
+     its nodes stay in that pool
+  */
+  rest = create_list_with_allocator((list->pool != NULL) ? NULL
+                                                          : list->allocator);
+  if (list->pool != NULL) {
+    rest->allocator = list->allocator;
+    rest->pool = share_pool(list->pool);
+  }
+  if (node == NULL) return rest;
+
+  /* Counts the nodes from node to the tail and from the head
+     to node at the same pace, until either end is reached
+  */
+  moved = (size_t)1;
+  kept = (size_t)0;
+  forward = node->next;
+  backward = node->prev;
+  while ((forward != NULL) && (backward != NULL)) {
+    moved++;
+    kept++;
+    forward = forward->next;
+    backward = backward->prev;
+  }
+  if (forward == NULL) {
+    kept = list->size - moved;
+  } else {
+    moved = list->size - kept;
+  }
+
+  rest->head = node;
+  rest->tail = list->tail;
+  rest->size = moved;
+  list->tail = node->prev;
+  if (list->tail != NULL) {
+    list->tail->next = NULL;
+  } else {
+    list->head = NULL;
+  }
+  node->prev = NULL;
+  list->size = kept;
+  list->finger = NULL;
+
+  return rest;
 }
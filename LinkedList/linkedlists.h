@@ -3,16 +3,34 @@
 
 #include <stdlib.h>
 
-typedef __node_t {
+#include "allocator.h"
+
+typedef struct __node_t {
   void *data;
-  __node_t *prev;
-  __node_t *next;
-}
-node_t;
+  struct __node_t *prev;
+  struct __node_t *next;
+} node_t;
+
+/* The list and its nodes are allocated with allocator,
+   which is NULL for malloc and free.
 
+   A list created with create_list_with_pool allocates its
+   nodes in pool, a pool of its own that only the lists split
+   from it share, and the list itself with malloc.
+
+   size is the number of elements. finger is the node last
+   reached by get_ith_element_of_list, the finger_index-th one,
+   or NULL. Code that links or unlinks nodes by itself must
+   keep size up to date and reset finger to NULL.
+*/
 typedef struct {
   node_t *head;
   node_t *tail;
+  allocator_t *allocator;
+  pool_t *pool;
+  size_t size;
+  node_t *finger;
+  size_t finger_index;
 } list_t;
 
 /* Creates a new empty list with no elements
@@ -21,10 +39,32 @@ typedef struct {
 */
 list_t *create_list(void);
 
+/* Creates a new empty list with no elements, allocating
+   the list and its nodes with the allocator in argument.
+   The allocator must outlive the list.
+
+   O(1)
+*/
+list_t *create_list_with_allocator(allocator_t *);
+
+/* Creates a new empty list with no elements, allocating
+   its nodes in a pool of its own. Nodes are then carved out
+   of slabs, removed nodes are reused, and deleting the list
+   gives back all its nodes at once.
+
+   O(1)
+
+   Lists sharing one pool are created with
+   create_list_with_allocator(get_pool_allocator(pool)),
+   with a pool of objects of sizeof(node_t) bytes.
+*/
+list_t *create_list_with_pool(void);
+
 /* Deletes a list, freeing all memory, calling the function
    in argument on all elements in order to free them
 
-   O(n)
+   O(n), plus O(number of slabs) instead of one free per
+   node for a list created with create_list_with_pool
 */
 void delete_list(list_t *, void (*)(void *, void *), void *);
 
@@ -36,7 +76,7 @@ int is_empty_list(list_t *);
 
 /* Returns the length of the list
 
-   O(n)
+   O(1)
 */
 size_t length_list(list_t *);
 
@@ -62,11 +102,23 @@ void iterate_over_list(list_t *, void (*)(void *, void *), void *);
 */
 void *search_list(list_t *, void *, int (*)(void *, void *, void *), void *);
 
+/* Same as search_list, but returns the node holding the first
+   element found equal, or NULL if no element matches. The node
+   can be given to the node operations below.
+
+   O(n)
+*/
+node_t *search_node_in_list(list_t *, void *, int (*)(void *, void *, void *),
+                            void *);
+
 /* Returns the i-th element of a list.
 
    Returns NULL if the list does not have an i-th element.
 
-   O(n)
+   O(min(i, n - i, |i - j|)), where j is the index last asked
+   for. Walks from the head, the tail or the node last reached,
+   whichever is nearest, so that looping over i = 0, ..., n - 1
+   or n - 1, ..., 0 takes O(n) in total.
 */
 void *get_ith_element_of_list(list_t *, size_t);
 
@@ -75,17 +127,94 @@ void *get_ith_element_of_list(list_t *, size_t);
 
    Calls the function in argument to copy the element.
 
+   Returns the node holding the copy.
+
    O(1)
 */
-void prepend_to_list(list_t *, void *, void *(*)(void *, void *), void *);
+node_t *prepend_to_list(list_t *, void *, void *(*)(void *, void *), void *);
 
 /* Modifies a list so that a given element is its new
    last element.
 
    Calls the function in argument to copy the element.
 
+   Returns the node holding the copy.
+
+   O(1)
+*/
+node_t *append_to_list(list_t *, void *, void *(*)(void *, void *), void *);
+
+/* The node operations below take nodes returned by
+   prepend_to_list, append_to_list, insert_after or
+   search_node_in_list, or reached through head, tail, prev and
+   next. A node must belong to the list it is given with, and
+   nodes only move between lists allocating their nodes with
+   the same allocator. A list created with create_list_with_pool
+   has an allocator of its own, which it shares with the lists
+   split from it only: its nodes only move between them.
+*/
+
+/* Modifies a list so that a given element follows the node in
+   argument, or is its new first element if the node is NULL.
+
+   Calls the function in argument to copy the element.
+
+   Returns the node holding the copy.
+
+   O(1)
+*/
+node_t *insert_after(list_t *, node_t *, void *, void *(*)(void *, void *),
+                     void *);
+
+/* Removes a node from a list and frees it.
+
+   Returns the element the node held, which is not freed.
+
    O(1)
 */
-void append_to_list(list_t *, void *, void *(*)(void *, void *), void *);
+void *remove_node(list_t *, node_t *);
+
+/* Takes a node out of a list without freeing it, so that it
+   can be linked into a list again with link_after.
+
+   O(1)
+*/
+void unlink_node(list_t *, node_t *);
+
+/* Links a node taken out of a list with unlink_node after the
+   node in argument, or as the first node if that node is NULL.
+   Nothing is allocated.
+
+   For instance, unlink_node(list, node) followed by
+   link_after(list, NULL, node) moves a node to the front.
+
+   O(1)
+*/
+void link_after(list_t *, node_t *, node_t *);
+
+/* Moves all nodes of the second list, in order, to the end of
+   the first one. The second list is left empty, to be deleted
+   or reused by the caller. No element is copied.
+
+   O(1)
+*/
+void splice_lists(list_t *, list_t *);
+
+/* Splits a list before the node in argument. The node and all
+   the nodes following it are moved, in order, to a new list,
+   which is returned. The list in argument keeps the nodes
+   preceding the node. No element is copied.
+
+   Returns a new empty list if the node is NULL.
+
+   The new list allocates its nodes with the allocator of the
+   list in argument. If that list has been created with
+   create_list_with_pool, both lists hold its pool, which is
+   deleted with the last of them.
+
+   O(min(i, n - i)) for the i-th node of a list of n nodes,
+   to count the nodes moved
+*/
+list_t *split_list_at(list_t *, node_t *);
 
 #endif
@@ -0,0 +1,157 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "allocator.h"
+#include "unrolledlists.h"
+
+unrolled_list_t *create_unrolled_list(void) {
+  return create_unrolled_list_with_allocator(NULL);
+}
+
+unrolled_list_t *create_unrolled_list_with_allocator(allocator_t *allocator) {
+  unrolled_list_t *list;
+
+  list = (unrolled_list_t *)allocate_memory(allocator, sizeof(unrolled_list_t));
+
+  list->head = NULL;
+  list->tail = NULL;
+  list->length = (size_t)0;
+  list->allocator = allocator;
+
+  return list;
+}
+
+void delete_unrolled_list(unrolled_list_t *list,
+                          void (*delete_data)(void *, void *), void *data) {
+  unrolled_node_t *curr, *next;
+  size_t i, end;
+
+  for (curr = list->head; curr != NULL; curr = next) {
+    next = curr->next;
+    end = ((size_t)curr->first) + ((size_t)curr->count);
+    for (i = (size_t)curr->first; i < end; i++) {
+      delete_data(curr->data[i], data);
+    }
+    free_memory(list->allocator, curr, sizeof(unrolled_node_t));
+  }
+
+  free_memory(list->allocator, list, sizeof(unrolled_list_t));
+}
+
+int is_empty_unrolled_list(unrolled_list_t *list) {
+  return (list->head == NULL);
+}
+
+size_t length_unrolled_list(unrolled_list_t *list) { return list->length; }
+
+void iterate_over_unrolled_list(unrolled_list_t *list,
+                                void (*operation)(void *, void *),
+                                void *data) {
+  unrolled_node_t *curr;
+  size_t i, end;
+
+  for (curr = list->head; curr != NULL; curr = curr->next) {
+    end = ((size_t)curr->first) + ((size_t)curr->count);
+    for (i = (size_t)curr->first; i < end; i++) {
+      operation(curr->data[i], data);
+    }
+  }
+}
+
+void *search_unrolled_list(unrolled_list_t *list, void *elem,
+                           int (*compare_elements)(void *, void *, void *),
+                           void *data) {
+  unrolled_node_t *curr;
+  size_t i, end;
+
+  for (curr = list->head; curr != NULL; curr = curr->next) {
+    end = ((size_t)curr->first) + ((size_t)curr->count);
+    for (i = (size_t)curr->first; i < end; i++) {
+      if (compare_elements(elem, curr->data[i], data) == 0) {
+        return curr->data[i];
+      }
+    }
+  }
+
+  return NULL;
+}
+
+void *get_ith_element_of_unrolled_list(unrolled_list_t *list, size_t i) {
+  unrolled_node_t *curr;
+
+  for (curr = list->head; curr != NULL; curr = curr->next) {
+    if (i < ((size_t)curr->count)) {
+      return curr->data[((size_t)curr->first) + i];
+    }
+    i -= (size_t)curr->count;
+  }
+
+  return NULL;
+}
+
+static unrolled_node_t *__alloc_unrolled_node(unrolled_list_t *list,
+                                              size_t first) {
+  unrolled_node_t *new_node;
+
+  new_node = (unrolled_node_t *)allocate_memory(list->allocator,
+                                                sizeof(unrolled_node_t));
+  new_node->prev = NULL;
+  new_node->next = NULL;
+  new_node->first = (uint32_t)first;
+  new_node->count = (uint32_t)0;
+
+  return new_node;
+}
+
+/* A new head node is filled from its end, so that the
+   following prepends find free slots before its first
+   element.
+*/
+void prepend_to_unrolled_list(unrolled_list_t *list, void *elem,
+                              void *(*copy_element)(void *, void *),
+                              void *data) {
+  unrolled_node_t *node;
+
+  node = list->head;
+  if ((node == NULL) || (node->first == ((uint32_t)0))) {
+    node = __alloc_unrolled_node(list, UNROLLED_NODE_ELEMENTS);
+    node->next = list->head;
+    if (list->head != NULL) {
+      list->head->prev = node;
+    }
+    list->head = node;
+    if (list->tail == NULL) {
+      list->tail = node;
+    }
+  }
+
+  node->data[node->first - ((uint32_t)1)] = copy_element(elem, data);
+  node->first--;
+  node->count++;
+  list->length++;
+}
+
+void append_to_unrolled_list(unrolled_list_t *list, void *elem,
+                             void *(*copy_element)(void *, void *),
+                             void *data) {
+  unrolled_node_t *node;
+
+  node = list->tail;
+  if ((node == NULL) || ((((size_t)node->first) + ((size_t)node->count)) >=
+                         UNROLLED_NODE_ELEMENTS)) {
+    node = __alloc_unrolled_node(list, (size_t)0);
+    node->prev = list->tail;
+    if (list->tail != NULL) {
+      list->tail->next = node;
+    }
+    list->tail = node;
+    if (list->head == NULL) {
+      list->head = node;
+    }
+  }
+
+  node->data[node->first + node->count] = copy_element(elem, data);
+  node->count++;
+  list->length++;
+}
@@ -0,0 +1,132 @@
+#ifndef __UNROLLED_LISTS_H__
+#define __UNROLLED_LISTS_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "allocator.h"
+
+/* Number of elements a node of an unrolled list holds, so
+   that a node fills two cache lines of 64 bytes on 64-bit
+   platforms
+*/
+#define UNROLLED_NODE_ELEMENTS ((size_t)13)
+
+/* A node holds its count elements in data[first], ...,
+   data[first + count - 1]. Appending fills the free slots
+   after them, prepending the free slots before them.
+*/
+typedef struct __unrolled_node_t {
+  struct __unrolled_node_t *prev;
+  struct __unrolled_node_t *next;
+  uint32_t first;
+  uint32_t count;
+  void *data[UNROLLED_NODE_ELEMENTS];
+} unrolled_node_t;
+
+/* The list and its nodes are allocated with allocator,
+   which is NULL for malloc and free.
+*/
+typedef struct {
+  unrolled_node_t *head;
+  unrolled_node_t *tail;
+  size_t length;
+  allocator_t *allocator;
+} unrolled_list_t;
+
+/* An unrolled list has the same operations and semantics as
+   a list_t, but keeps up to UNROLLED_NODE_ELEMENTS elements
+   in each node instead of one. Iterating and searching then
+   read the element pointers of a node from one or two cache
+   lines, and take one cache miss every UNROLLED_NODE_ELEMENTS
+   elements instead of one per element. The list takes about
+   10 bytes per element instead of 24.
+*/
+
+/* Creates a new empty unrolled list with no elements
+
+   O(1)
+*/
+unrolled_list_t *create_unrolled_list(void);
+
+/* Creates a new empty unrolled list with no elements,
+   allocating the list and its nodes with the allocator in
+   argument. The allocator must outlive the list.
+
+   O(1)
+*/
+unrolled_list_t *create_unrolled_list_with_allocator(allocator_t *);
+
+/* Deletes an unrolled list, freeing all memory, calling the
+   function in argument on all elements in order to free them
+
+   O(n)
+*/
+void delete_unrolled_list(unrolled_list_t *, void (*)(void *, void *), void *);
+
+/* Returns 0 if the unrolled list is not empty, non-zero
+   otherwise
+
+   O(1)
+*/
+int is_empty_unrolled_list(unrolled_list_t *);
+
+/* Returns the length of the unrolled list
+
+   O(1)
+*/
+size_t length_unrolled_list(unrolled_list_t *);
+
+/* Iterates over all elements of the unrolled list,
+   calling the function in argument on each element.
+
+   O(n)
+*/
+void iterate_over_unrolled_list(unrolled_list_t *, void (*)(void *, void *),
+                                void *);
+
+/* Searches the unrolled list for an element, comparing
+   with the function in argument.
+
+   The function in argument must return 0 if the
+   elements are indeed equal.
+
+   Returns the first element that is found
+   equal.
+
+   Returns NULL if no element matches.
+
+   O(n)
+*/
+void *search_unrolled_list(unrolled_list_t *, void *,
+                           int (*)(void *, void *, void *), void *);
+
+/* Returns the i-th element of an unrolled list.
+
+   Returns NULL if the list does not have an i-th element.
+
+   O(n / UNROLLED_NODE_ELEMENTS)
+*/
+void *get_ith_element_of_unrolled_list(unrolled_list_t *, size_t);
+
+/* Modifies an unrolled list so that a given element is its
+   new first element.
+
+   Calls the function in argument to copy the element.
+
+   O(1)
+*/
+void prepend_to_unrolled_list(unrolled_list_t *, void *,
+                              void *(*)(void *, void *), void *);
+
+/* Modifies an unrolled list so that a given element is its
+   new last element.
+
+   Calls the function in argument to copy the element.
+
+   O(1)
+*/
+void append_to_unrolled_list(unrolled_list_t *, void *,
+                             void *(*)(void *, void *), void *);
+
+#endif
@@ -5,15 +5,11 @@
 #include <sys/stat.h>
 #include <time.h>
 
+#include "intern.h"
 #include "redblacktrees.h"
 
 #define LINE_BUFFER_LEN ((size_t)4096)
 
-static void error_no_mem(void) {
-  fprintf(stderr, "Error: no memory left.\n");
-  exit(1);
-}
-
 static void input_string(char str[], size_t n) {
   char c;
   size_t i;
@@ -39,36 +35,32 @@ static void input_string(char str[], size_t n) {
   str[i] = '\0';
 }
 
-static void delete_string(void *ptr) { free(ptr); }
-
-static void delete_key(void *ptr, void *data) { delete_string(ptr); }
-
-static void delete_value(void *ptr, void *data) { delete_string(ptr); }
+/* The keys and values are interned in the pool given as the
+   data pointer, which owns them
+*/
+static void delete_key(void *ptr, void *data) {}
 
-static void *copy_string(void *ptr) {
-  char *str = ptr;
-  size_t len;
-  char *new_str;
+static void delete_value(void *ptr, void *data) {}
 
-  len = strlen(ptr);
-  len++;
+static void *copy_string(void *ptr, void *data) {
+  intern_pool_t *pool = data;
 
-  new_str = calloc(len, sizeof(char));
-  if (new_str == NULL) error_no_mem();
-
-  strcpy(new_str, str);
-
-  return new_str;
+  return (void *)intern_string(pool, ptr);
 }
 
-static void *copy_key(void *ptr, void *data) { return copy_string(ptr); }
+static void *copy_key(void *ptr, void *data) { return copy_string(ptr, data); }
 
-static void *copy_value(void *ptr, void *data) { return copy_string(ptr); }
+static void *copy_value(void *ptr, void *data) {
+  return copy_string(ptr, data);
+}
 
+/* Interned strings are equal iff they are the same pointer */
 static int compare_key(const void *ptr_a, const void *ptr_b, void *data) {
   const char *str_a = ptr_a;
   const char *str_b = ptr_b;
 
+  if (str_a == str_b) return 0;
+
   return strcmp(str_a, str_b);
 }
 
@@ -86,8 +78,10 @@ static void rbt_menu(void) {
   char value[LINE_BUFFER_LEN];
   char *temp_key, *temp_value;
   red_black_tree_t *tree;
+  intern_pool_t *pool;
 
   tree = red_black_tree_create();
+  pool = create_intern_pool();
 
   while (1) {
     rbt_print_menu();
@@ -142,7 +136,7 @@ static void rbt_menu(void) {
               key, value, temp_value);
         } else {
           red_black_tree_insert(tree, key, value, compare_key, copy_key,
-                                copy_value, NULL);
+                                copy_value, pool);
         }
         break;
       case 3:
@@ -192,7 +186,7 @@ static void rbt_menu(void) {
         input_string(key, sizeof(key));
         if (strcmp(key, "<N>") != 0) {
           red_black_tree_remove(tree, key, compare_key, delete_key,
-                                delete_value, NULL);
+                                delete_value, pool);
         }
         break;
       case 5:
@@ -204,7 +198,8 @@ static void rbt_menu(void) {
   }
 
   // Delete everything from tree
-  red_black_tree_delete(tree, delete_key, delete_value, NULL);
+  red_black_tree_delete(tree, delete_key, delete_value, pool);
+  delete_intern_pool(pool);
 }
 
 static char *rand_string(char *str, size_t size) {
@@ -236,8 +231,10 @@ static void automatic_test_rbt(void) {
   int shifts, i;
 
   red_black_tree_t *rbt;
+  intern_pool_t *pool;
 
   rbt = red_black_tree_create();
+  pool = create_intern_pool();
 
   printf(
       "n_keys,max_height,insert,search_existent,search_non_existent,remove_"
@@ -256,7 +253,7 @@ static void automatic_test_rbt(void) {
 
         t = clock();
         red_black_tree_insert(rbt, keys[i], value, compare_key, copy_key,
-                              copy_value, NULL);
+                              copy_value, pool);
         rbt_time += (clock() - t);
       }
     }
@@ -288,14 +285,15 @@ static void automatic_test_rbt(void) {
     for (i = 0; i < n_keys; ++i) {
       t = clock();
       red_black_tree_remove(rbt, keys[i], compare_key, delete_key, delete_value,
-                            NULL);
+                            pool);
       rbt_time += (clock() - t);
     }
     printf("%f\n", ((double)rbt_time) / CLOCKS_PER_SEC);
   }
 
   // Delete everything from tree
-  red_black_tree_delete(rbt, delete_key, delete_value, NULL);
+  red_black_tree_delete(rbt, delete_key, delete_value, pool);
+  delete_intern_pool(pool);
 }
 
 static void print_wait_message(int n) {